@@ -26,6 +26,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <limits.h>
 #include <time.h>
@@ -68,11 +69,168 @@
 #define MAX_OPTION 100
 #define MAX_GAMES 15
 #define MAX_MESSAGE 100
+#define MAX_PLATFORMS (ROOMS * TILES)
+#define MAX_LOOSE 32 /*** Loose floors that wobble or fall at the same time. ***/
+#define ROOM_W 12 /*** 10 tiles, plus a ghost column on both sides. ***/
+#define ROOM_H 5 /*** 3 tiles, plus a ghost row above and below. ***/
+#define ROOM_CELLS (ROOM_W * ROOM_H)
+#define CELLS ((((ROOMS + 1) * ROOM_CELLS) + 63) & ~63) /*** Whole lines. ***/
+#define MAX_GATES 255
+#define DIRS 6
+#define TO_LEFT 1
+#define TO_RIGHT 2
+#define TO_UP 3
+#define TO_DOWN 4
+#define TO_UPLEFT 5
+#define TO_UPRIGHT 6
+#define BENCH_ROUNDS 2000
+#define SEQ_NONE 0
+#define SEQ_DEATH 1
+#define SEQ_HURT 2 /*** Hurt potion. ***/
+#define SEQ_LEVEL 3 /*** To the next level. ***/
+#define SEQ_VICTORY 4
+#define DEATH_TICKS 12 /*** In game ticks; about a second. ***/
+#define HURT_TICKS 6
+#define LEVEL_TICKS 3
+#define VICTORY_TICKS 50
+#define MAX_HELD 16 /*** Keys pressed while a sequence runs. ***/
+#define MAX_MOVES 32 /*** Arrow keys waiting for their game tick. ***/
+#define LATENCY_MS 1000 /*** Latencies are counted per ms, up to this. ***/
+#define OVL_NONE 0
+#define OVL_MESSAGE 1
+#define OVL_POPUP 2 /*** Yes or no. ***/
+#define OVL_BOSSKEY 3
+#define OVL_SIGN 4
+#define GATE_TICKS 125 /*** = 10 seconds ***/
+#define GATE_FOREVER 45000 /*** = 1 hour, should be enough ***/
+#define WHEEL_LEVELS 3
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS) /*** Covers the 65536 Uint16 ticks. ***/
+#define TILE_EMPTY 0x0001 /*** Falls through it. ***/
+#define TILE_FLOOR 0x0002 /*** Can stand on it. ***/
+#define TILE_WALL 0x0004
+#define TILE_GATE 0x0008
+#define TILE_DOOR 0x0010 /*** Level door. ***/
+#define TILE_BUTTON 0x0020
+#define TILE_RAISE 0x0040 /*** Raise button; without it, drop button. ***/
+#define TILE_TELEPORT 0x0080
+#define TILE_LOOSE 0x0100
+#define TILE_POTION 0x0200
+#define TILE_SPIKES 0x0400
+#define TILE_CHOMPER 0x0800
+#define TILE_HAZARD 0x1000 /*** Spikes or chomper, in any state. ***/
+#define TILE_PLATFORM 0x2000
+#define TILE_TORCH 0x4000 /*** Flickering background. ***/
+#define TILE_BITS 15
+#define ACT_NONE 0
+#define ACT_SPIKES 1
+#define ACT_LOOSE 2
+#define ACT_BUTTON 3
+#define ACT_CHOMPER 4
+#define ACT_COIN 5
+#define ACT_REVEAL 6 /*** Becomes a floor. ***/
+#define ACT_SWORD 7
+#define ACT_EMPTY 8
+#define ACT_HEAL 9
+#define ACT_LIFE 10
+#define ACT_FLOAT 11
+#define ACT_HURT 12
+#define ACT_BLUE 13
+#define ACTS 14
+#define DAT_GROUPS 44 /*** 0-32, and 43 for stuck loose. ***/
+#define DAT_BUTTON 1 /*** In arDatTile; a letter from GetLetter(). ***/
+#define BOARDS 6
+#define BOARD_FLOOR 0
+#define BOARD_EMPTY 1
+#define BOARD_SPIKES 2
+#define BOARD_CHOMPER 3
+#define BOARD_LOOSE 4
+#define BOARD_GATE 5
+#define BOARD_ALL 0x3fffffff /*** Bit (tile - 1) for all 30 tiles. ***/
+/*** From arTile on, struct game is what Snapshot() copies. ***/
+#define SNAPSHOT_SIZE (sizeof (struct game) - offsetof (struct game, arTile))
+#define REWIND_TICKS 750 /*** A minute of game ticks. ***/
+#define REWIND_KEY 125 /*** A keyframe every 10 seconds. ***/
+#define REWIND_BYTES (384 * 1024)
+#define MOVE_WALK 1 /*** Walk, jump and run-jump are also their turns. ***/
+#define MOVE_CAREFUL 2
+#define MOVE_JUMP 3
+#define MOVE_RUNJUMP 6
+#define SOLVE_MOVES 12
+#define SOLVE_SWORD 11 /*** The move that swings the sword. ***/
+#define SOLVE_THREADS 64
+#define SOLVE_PHASES 25 /*** Guard and chomper phases repeat every 2 seconds. ***/
+#define SOLVE_ANY_PHASE 0x6a09e667f3bcc908ULL /*** In keys of phase-free nodes. ***/
+#define SOLVE_MAX_SECONDS 120 /*** Per level. ***/
+#define SOLVE_TABLE (1 << 23) /*** Seen states; a power of 2. ***/
+#define SOLVE_MAX_STATES (SOLVE_TABLE / 2)
+#define SOLVE_LEFT 3 /*** Gate timers kept apart from the key; see StateKey(). ***/
+#define SOLVE_TAG 48 /*** Where the phase is in the arSolveLeft values. ***/
+#define SOLVE_LIVES 56 /*** And the lives. ***/
+#define SOLVE_TICKS (((Uint64)1 << SOLVE_TAG) - 1) /*** Those of the gates. ***/
+#define SOLVE_OK 0
+#define SOLVE_DEAD 1
+#define SOLVE_GOAL 2
+#define SOLVE_GAVE_UP -2 /*** From SolveLevel(), when a cap was hit. ***/
+#define REACH_STAND 0x01 /*** Can stand on it, at some point. ***/
+#define REACH_PASS 0x02 /*** Can walk or jump through it. ***/
+#define REACH_HOLE 0x04 /*** Can fall through it, at some point. ***/
+#define MAX_GUARDS 64 /*** A bit each in arRoomGuards. ***/
+#define MAX_TRIGGERS 64
+#define MAX_CODE 1024
+#define TRIG_FLAGS 8
+#define TRIG_START 0 /*** The level starts. ***/
+#define TRIG_ENTER 1 /*** The prince is about to walk, jump or climb in. ***/
+#define TRIG_TICK 2 /*** Every game tick, while in the room. ***/
+#define TRIG_FALL 3 /*** The prince falls out of the level. ***/
+#define TRIG_GATE 4 /*** A button opens the gate. ***/
+#define TRIG_DOOR 5 /*** A button opens the level door. ***/
+#define TRIG_SWORD 6 /*** The prince picks up the sword. ***/
+#define TRIG_KILL 7 /*** The prince kills the guard. ***/
+#define TRIG_EVENTS 8
+#define CODE_END 0
+#define CODE_GUARD 1
+#define CODE_MOVEGUARD 2
+#define CODE_PRESS 3
+#define CODE_CRUSH 4
+#define CODE_TILE 5
+#define CODE_DRINK 6
+#define CODE_FLASH 7
+#define CODE_LEVEL 8
+#define CODE_VICTORY 9
+#define CODE_FACE 10
+#define CODE_HANG 11
+#define CODE_SET 12
+#define CODE_ADD 13
+#define CODE_IFEQ 14
+#define CODE_IFGT 15
+#define CODE_IFRUN 16
+#define CODE_IFDIR 17
+#define CODE_IFFROM 18
+#define CODE_IFGUARD 19
+#define CODE_IFSIDE 20
+#define CODES 21
 
 #ifndef O_BINARY
 #define O_BINARY 0
 #endif
 
+#if defined __GNUC__
+#define CACHE_ALIGNED __attribute__ ((aligned (64)))
+#define THREAD_LOCAL __thread
+#define ATOMIC_CAS64 1
+#elif defined _MSC_VER
+#define CACHE_ALIGNED
+#define THREAD_LOCAL __declspec (thread)
+#elif defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L
+#define CACHE_ALIGNED
+#define THREAD_LOCAL _Thread_local
+#else
+#define CACHE_ALIGNED
+#define THREAD_LOCAL
+#define NO_THREAD_LOCAL 1 /*** stGame is shared; the solver uses 1 thread. ***/
+#endif
+
 #if defined WIN32 || _WIN32 || WIN64 || _WIN64
 #define SLASH "\\"
 #else
@@ -81,7 +239,6 @@
 /*========== Defines ==========*/
 
 char cNextDrop, cNextRaise;
-int iCurLevel, iCurRoom;
 SDL_Window *window;
 SDL_Renderer *ascreen;
 SDL_Cursor *curArrow;
@@ -93,20 +250,42 @@ Uint32 oldticks, newticks;
 unsigned int progspeed;
 Uint32 looptime;
 int iOnYes, iOnNo;
-int iGoRoom, iGoTile;
 int iStartLevel;
 int iMode;
 int iZoom;
 int iCheat;
+int iBenchmark;
+int iSolve;
+int iNoWait;
+int iDebugHash;
+int iHeadless; /*** No window; for --solve. ***/
+int iAnalyze;
+int iAgent;
 int iFullscreen;
-int iJump;
-int iCareful;
-int iRunJump;
-int iMaxLives;
-int iCurLives;
-int iLevLives; /*** Obtained during iCurLevel. ***/
+/*** Keys held while a sequence runs. ***/
+SDL_Event arHeld[MAX_HELD + 2];
+int iNrHeld;
+/*** Arrow keys, played one per game tick in the order they came. ***/
+struct move
+{
+	int iDir; /*** 0 for a mode key. ***/
+	int iKey; /*** Of a mode key: MOVE_JUMP, MOVE_CAREFUL or MOVE_RUNJUMP. ***/
+	Uint32 iAt; /*** SDL_GetTicks() of the key. ***/
+};
+struct move arMoves[MAX_MOVES];
+int iMoveFirst, iNrMoves;
+int iMovesDropped;
+int iMoveShown; /*** 0 while the last move waits for ShowGame(). ***/
+Uint32 iMoveAt;
+Uint32 arLatency[LATENCY_MS + 1]; /*** Moves per input-to-render ms. ***/
+/*** ShowGame() draws the overlay; the level waits while one is up. ***/
+int iOverlay;
+char sOverlay[MAX_MESSAGE + 2];
+SDL_Texture *imgsign;
+int iSignWarn;
+int iSignMode, iSignZoom; /*** To restore. ***/
 int iXPos, iYPos;
-char sMessage[MAX_MESSAGE + 2];
+THREAD_LOCAL char sMessage[MAX_MESSAGE + 2];
 char sSignPathFile[MAX_PATHFILE + 2];
 
 /*** DAT ***/
@@ -139,50 +318,495 @@ int arEventsNext[EVENTS + 2];
 int iNrGames;
 char arGames[MAX_PATHFILE + 2][MAX_GAMES + 2];
 int iGameSel;
+int iTilesGame; /*** Whose tiles are in the tile tables; 0 = none yet. ***/
 
-/*** For running games. ***/
-char arTiles[ROOMS + 2][TILES + 2];
-char arMobBck[ROOMS + 2][TILES + 2];
-int arMobDir[ROOMS + 2][TILES + 2]; /*** 1(5)=l, 2(6)=r, 3(7)=u, 4(8)=d ***/
-int arGateTimers[ROOMS + 2][TILES + 2];
-int arLettersRoom[(int)'r' + 2][10 + 2];
-int arLettersTile[(int)'r' + 2][10 + 2];
-int arLinksL[ROOMS + 2];
-int arLinksR[ROOMS + 2];
-int arLinksU[ROOMS + 2];
-int arLinksD[ROOMS + 2];
-int iPrinceTile;
-int iPrinceDir; /*** Keeping track of this for climbing and such. ***/
-int iPrinceHang; /*** 1 = Hanging allowed. 2 = Currently hanging. ***/
-int iPrinceSword;
-int iPrinceFloat;
-int iPrinceSafe;
-int iPrinceCoins;
-/***/
-int arGuardLoc[ROOMS + 2];
-/***
-1 = [E]asy
-2 = [H]ard
-3 = [J]affar
-4 = [S]hadow
-5 = [M]ouse
-***/
-int arGuardType[ROOMS + 2];
-int arGuardHP[ROOMS + 2];
-int arGuardAttack[ROOMS + 2];
-/***/
-int iFlash;
-int iFlashR, iFlashG, iFlashB;
-/***/
-int iSteps; /*** Coins are in iPrinceCoins. ***/
-int iShowStepsCoins;
-/***/
-int iCoinsInLevel;
-int iNoMessage;
-/***/
-int iMouse;
-int iMirror;
+/*** For special events. ***/
+struct trigger
+{
+	int iEvent;
+	int iRoom, iTile; /*** 0 for any. ***/
+	int iCode; /*** First instruction in arTrigCode. ***/
+};
+struct codedef
+{
+	const char *sName;
+	int iArgs;
+	int iCell; /*** The first two arguments are a room and tile. ***/
+	int iFlag; /*** The first argument is a flag. ***/
+};
+static const char *arTrigName[TRIG_EVENTS] = {"start", "enter", "tick",
+	"fall", "gate", "door", "sword", "kill"};
+static const struct codedef arCodeDefs[CODES] = {
+	{"end", 0, 0, 0},
+	{"guard", 3, 1, 0}, /*** room tile type; replaces one on the tile ***/
+	{"moveguard", 2, 1, 0}, /*** room tile; the first guard of room ***/
+	{"press", 2, 1, 0}, /*** room tile ***/
+	{"crush", 2, 1, 0}, /*** room tile; as if a loose floor fell on it ***/
+	{"tile", 3, 1, 0}, /*** room tile char ***/
+	{"drink", 2, 1, 0}, /*** room tile; empties a potion ***/
+	{"flash", 3, 0, 0}, /*** r g b ***/
+	{"level", 0, 0, 0},
+	{"victory", 0, 0, 0},
+	{"face", 1, 0, 0}, /*** 1 = left, 2 = right ***/
+	{"hang", 0, 0, 0},
+	{"set", 2, 0, 1}, /*** flag value ***/
+	{"add", 2, 0, 1}, /*** flag value ***/
+	{"ifeq", 2, 0, 1}, /*** flag value ***/
+	{"ifgt", 2, 0, 1}, /*** flag value ***/
+	{"ifrun", 0, 0, 0},
+	{"ifdir", 1, 0, 0}, /*** 1 = left, 2 = right ***/
+	{"iffrom", 1, 0, 0}, /*** room ***/
+	{"ifguard", 1, 0, 0}, /*** type; of the guard on the event tile ***/
+	{"ifside", 0, 0, 0} /*** a walk or jump to the side, not a climb ***/
+};
+/*** Used if a game has no levelNNx.txt file. See ReadTriggers(). ***/
+static const char *arDefaultTriggers[14 + 2] = {
+	"",
+	/*** 1 ***/ "start 0 0 press 5 3\n",
+	/*** 2 ***/ "",
+	/*** 3 ***/ "",
+	/*** 4 ***/ "enter 4 5 ifside ifrun ifdir 1 ifeq 1 2 guard 4 6 4\n"
+		"door 0 0 set 1 1\n"
+		"tick 11 0 ifeq 1 1 tile 4 5 % set 1 2\n",
+	/*** 5 ***/ "gate 24 2 guard 24 4 4 drink 24 4\n",
+	/*** 6 ***/ "start 0 0 guard 1 11 4\n"
+		"enter 1 1-5 ifrun ifdir 1 moveguard 1 12 crush 1 12\n"
+		"enter 1 11-15 ifrun ifdir 1 moveguard 1 12 crush 1 12\n"
+		"enter 1 21-25 ifrun ifdir 1 moveguard 1 12 crush 1 12\n"
+		"fall 3 0 level\n",
+	/*** 7 ***/ "start 0 0 face 1 hang\n",
+	/*** 8 ***/ "door 0 0 set 1 1\n"
+		"tick 16 0 ifgt 1 0 add 1 1 ifgt 1 150 guard 16 8 5 press 16 8"
+		" set 1 -1\n",
+	/*** 9 ***/ "",
+	/*** 10 ***/ "",
+	/*** 11 ***/ "",
+	/*** 12 ***/ "sword 15 2 tile 2 1 9 tile 2 2 9 tile 2 3 9 tile 2 4 9\n"
+		"sword 15 2 tile 2 5 9 tile 2 6 9 tile 2 7 9 tile 2 8 9\n"
+		"sword 15 2 tile 13 7 9 tile 13 8 9 tile 13 9 9 tile 13 10 9\n"
+		"enter 23 0 iffrom 13 ifside ifdir 1 level\n",
+	/*** 13 ***/ "kill 0 0 ifguard 3 press 24 1 flash 255 255 255\n",
+	/*** 14 ***/ "enter 5 0 ifside ifdir 1 victory\n"
+};
 
+/*** For running games. ***/
+/*** All of one game, so that a process can run many of them. The ***/
+/*** functions work on the game stGame points to, see UseGame(). ***/
+/*** A cell is (room * ROOM_CELLS) + the position in the room, see ***/
+/*** arTileCell. Around the 3x10 tiles of a room lie ghost cells that ***/
+/*** copy the tiles of the neighbouring rooms, so that neighbours are ***/
+/*** always at the offsets in arDirOffset. ***/
+struct game
+{
+	/*** The level, as ReadLevel() left it. ***/
+	int arLinksL[ROOMS + 2];
+	int arLinksR[ROOMS + 2];
+	int arLinksU[ROOMS + 2];
+	int arLinksD[ROOMS + 2];
+	/*** Where ghost cells copy from; 0 is the wall outside the level. ***/
+	Uint16 arReal[CELLS];
+	Uint16 arGhostNext[CELLS]; /*** From a cell, the chain of its copies. ***/
+	Uint8 arGate[CELLS]; /*** Gate number, or 0. ***/
+	Uint16 arGateCell[MAX_GATES + 1];
+	int iNrGates;
+	/*** The cells of button c are arTargets[arButtonFirst[c]] up to, but ***/
+	/*** not including, arTargets[arButtonFirst[c + 1]]. ***/
+	int arButtonFirst[256 + 1];
+	Uint16 *arTargets;
+	int iTargetsSize;
+	Uint16 arTeleport[256][2]; /*** First two cells per teleport letter. ***/
+	/*** Per prince tile, for the room in iHazardRoom. ***/
+	int iHazardRoom;
+	Uint32 arSpikesNear[TILES + 2]; /*** Tiles where spikes come out. ***/
+	Uint32 arChompRow[TILES + 2]; /*** Tiles where chompers chomp. ***/
+	/*** Special events. Bit r of arTrigRooms[e] is set if room r has ***/
+	/*** triggers for event e; bit 0 if a trigger is for any room. ***/
+	struct trigger arTrigger[MAX_TRIGGERS + 1];
+	int iNrTriggers;
+	Sint16 arTrigCode[MAX_CODE];
+	int iCodeSize;
+	Uint32 arTrigRooms[TRIG_EVENTS];
+
+	/*** The live level. From here on, only plain values; no pointers. ***/
+	Uint8 arTile[CELLS];
+	Uint8 arMobBck[CELLS];
+	Uint8 arMobDir[CELLS]; /*** 1=l, 2=r, 3=u, 4=d ***/
+	/*** Per room, per BOARD_*, bit (tile - 1) is set if the tile is one. ***/
+	Uint32 arBoard[ROOMS + 2][BOARDS];
+	Uint16 arGateExpiry[MAX_GATES + 1]; /*** Tick the gate closes. ***/
+	/*** Gate timers, in a timing wheel. ***/
+	Uint8 arWheel[WHEEL_LEVELS][WHEEL_SLOTS]; /*** First gate in slot, or 0. ***/
+	Uint8 arWheelNext[MAX_GATES + 1];
+	Uint8 arWheelPrev[MAX_GATES + 1];
+	Uint8 arWheelSlot[MAX_GATES + 1]; /*** (level * WHEEL_SLOTS) + slot + 1. ***/
+	Uint16 iGameTick; /*** Wraps, as do the expiry ticks. ***/
+	Uint64 iHash; /*** Of the tiles and gate timers; see HashGame(). ***/
+	/*** Only these are visited on every game tick. ***/
+	int arPlatformRoom[MAX_PLATFORMS + 2];
+	int arPlatformTile[MAX_PLATFORMS + 2];
+	int iNrPlatforms;
+	int arLooseCell[MAX_LOOSE + 2]; /*** Where the loose floor is now. ***/
+	int arLoosePhase[MAX_LOOSE + 2]; /*** Ticks since it started to wobble. ***/
+	int iNrLoose;
+	int iMobMove;
+	int arFlag[TRIG_FLAGS]; /*** For the special events. ***/
+
+	/*** The prince. ***/
+	int iCurLevel, iCurRoom;
+	int iPrinceTile;
+	int iPrinceDir; /*** Keeping track of this for climbing and such. ***/
+	int iPrinceHang; /*** 1 = Hanging allowed. 2 = Currently hanging. ***/
+	int iPrinceFall; /*** 1 = Currently falling. ***/
+	int iPrinceFallRows; /*** Rows fallen so far. ***/
+	int iPrinceSword;
+	int iPrinceFloat;
+	int iPrinceSafe;
+	int iPrinceCoins;
+	int iJump;
+	int iCareful;
+	int iRunJump;
+	int iGoRoom, iGoTile;
+	int iGoSide; /*** 1 while TryGoSide() runs the enter triggers. ***/
+	int iMaxLives;
+	int iCurLives;
+	int iLevLives; /*** Obtained during iCurLevel. ***/
+	/***/
+	/*** The guards, as parallel arrays; see AddGuard(). ***/
+	int iNrGuards;
+	int arGuardRoom[MAX_GUARDS];
+	int arGuardLoc[MAX_GUARDS]; /*** The tile. ***/
+	/***
+	1 = [E]asy
+	2 = [H]ard
+	3 = [J]affar
+	4 = [S]hadow
+	5 = [M]ouse
+	***/
+	int arGuardType[MAX_GUARDS];
+	int arGuardHP[MAX_GUARDS];
+	int arGuardAttack[MAX_GUARDS];
+	Uint64 arRoomGuards[ROOMS + 2]; /*** Bit iGuard for each guard in it. ***/
+
+	/*** The session. ***/
+	int iFlash;
+	int iFlashR, iFlashG, iFlashB;
+	int iSteps; /*** Coins are in iPrinceCoins. ***/
+	int iShowStepsCoins;
+	int iCoinsInLevel;
+	int iNoMessage;
+	/*** While a sequence runs, the level waits and keys are held. ***/
+	int iSequence;
+	int iSequenceTicks; /*** Left. ***/
+	int iSequenceCell; /*** Of the hurt potion. ***/
+	Uint32 iPlayTicks, iSequenceTotal; /*** Game ticks, counted apart. ***/
+};
+struct game stFirstGame CACHE_ALIGNED;
+THREAD_LOCAL struct game *stGame = &stFirstGame;
+/*** A saved game; the level part is read again if needed. ***/
+struct snapshot
+{
+	int iLevel; /*** 0 = empty. ***/
+	Uint8 sLive[SNAPSHOT_SIZE];
+};
+struct snapshot stQuickSave; /*** F5 saves, F8 loads. ***/
+/*** Rewind history, played back while backspace is held. Every tick is ***/
+/*** stored in arRewind as the changes since the tick before it, except ***/
+/*** keyframes, that are stored whole. ***/
+Uint8 arRewind[REWIND_BYTES];
+int arRewindAt[REWIND_TICKS]; /*** Where the tick is in arRewind. ***/
+int arRewindSize[REWIND_TICKS];
+int arRewindLevel[REWIND_TICKS];
+Uint8 arRewindKey[REWIND_TICKS];
+int iRewindFirst, iRewindNr; /*** Oldest tick (slot), and ticks kept. ***/
+int iRewindHead; /*** Where the next tick goes. ***/
+int iRewindSinceKey;
+int iRewinding;
+Uint32 iRewindMaxUs; /*** Slowest step back. ***/
+struct snapshot stRewindLast; /*** The newest tick, whole. ***/
+Uint8 sRewindDelta[SNAPSHOT_SIZE * 2];
+Uint64 arZobrist[CELLS]; /*** Per cell; mixed with what is in it. ***/
+/*** For --solve. A node is a state, stored as its changes from the ***/
+/*** start of the level (stSolveBase). Each worker thread plays the ***/
+/*** nodes on its own struct game. ***/
+struct solvenode
+{
+	struct solvenode *stParent;
+	struct solvenode *stNextNode; /*** All nodes of a worker, to free. ***/
+	int iMove;
+	/*** If it stands for more phases: where to wait; see SolveNode(). ***/
+	struct solvenode *stAnchor;
+	Uint64 iSlow; /*** The gate time waiting at stAnchor costs. ***/
+	int iShift; /*** Ticks waited at the anchor of stParent first. ***/
+	Uint8 sDelta[];
+};
+struct solveworker
+{
+	struct game *stWorkGame;
+	struct snapshot stNode;
+	struct snapshot stMove; /*** For SolveQuiet(). ***/
+	Uint8 sDelta[SNAPSHOT_SIZE * 2];
+	struct solvenode *stNodes;
+	struct solvenode **arWait; /*** Same steps, one tick later. ***/
+	int iNrWait, iMaxWait;
+	struct solvenode **arNext; /*** One step more. ***/
+	int iNrNext, iMaxNext;
+};
+struct snapshot stSolveBase;
+struct solvenode **arSolveList;
+int iSolveNr, iSolveMax;
+int iSolveFrom; /*** The nodes to run are arSolveList[iSolveFrom...]. ***/
+int iSolveSteps; /*** 0 = run the waits, 1 = the steps. ***/
+SDL_atomic_t stSolveAt; /*** Next node, from iSolveFrom on. ***/
+SDL_atomic_t stSolveStates;
+SDL_atomic_t stSolveFound;
+SDL_atomic_t stSolveStop; /*** 1 when a cap is hit. ***/
+Uint32 iSolveStart;
+struct solvenode *stSolveGoal;
+Uint64 *arSolveSeen; /*** Open addressing; 0 is free. ***/
+Uint64 *arSolveFirst; /*** Per slot of arSolveSeen: its last value. ***/
+Uint64 *arSolveLeft; /*** The values, from 1 on; see LeftCovers(). ***/
+Uint32 *arSolveNext; /*** Per value: the one before it, of its key. ***/
+SDL_atomic_t stSolveLefts;
+THREAD_LOCAL int iSolveClock; /*** 1 once a tick has read the clock. ***/
+#ifndef ATOMIC_CAS64
+SDL_SpinLock iSolveLock;
+#endif
+static const int arSolveDir[SOLVE_MOVES] = {0, TO_LEFT, TO_RIGHT, TO_UP,
+	TO_DOWN, TO_LEFT, TO_RIGHT, TO_LEFT, TO_RIGHT, TO_LEFT, TO_RIGHT, 0};
+static const int arSolveMove[SOLVE_MOVES] = {0, MOVE_WALK, MOVE_WALK, 0, 0,
+	MOVE_JUMP, MOVE_JUMP, MOVE_RUNJUMP, MOVE_RUNJUMP, MOVE_CAREFUL,
+	MOVE_CAREFUL, 0};
+static const char *arSolveName[SOLVE_MOVES] = {"wait", "left", "right", "up",
+	"down", "jump-left", "jump-right", "run-left", "run-right",
+	"careful-left", "careful-right", "sword"};
+/*** For --agent: what AgentStep() saw, and where it left the prince. ***/
+struct agentstep
+{
+	/*** Summed over the ticks. ***/
+	int iCoins;
+	int iHurt; /*** Lives lost. ***/
+	int iDeaths;
+	int iExits;
+	/*** After the last tick. ***/
+	int iLevel, iRoom, iTile, iDir;
+	int iLives;
+	int iSequence;
+	Uint64 iHash;
+};
+Uint8 arReached[CELLS];
+Uint8 arReachExtra[CELLS]; /*** Opened gates and platform paths. ***/
+Uint8 arReachHit[CELLS]; /*** Hit by a falling loose floor. ***/
+Uint8 arReachPress[CELLS]; /*** Pressed by a special event. ***/
+int arReachQueue[CELLS];
+int iReachNr;
+int iReachFloat; /*** A float potion was reached. ***/
+int iReachExit; /*** A special event ends the level. ***/
+int iAnalyzeWarnings;
+int arTileCell[TILES + 2];
+int arCellTile[ROOM_CELLS]; /*** 0 for ghost cells. ***/
+int arDirOffset[DIRS + 2] = {0, -1, 1, -ROOM_W, ROOM_W,
+	-ROOM_W - 1, -ROOM_W + 1};
+/*** A run-jump goes through a mirror (level 4) only to the left. ***/
+int arSideMirror[DIRS + 2] = {0, 1, 0, 0, 0, 0, 0};
+/*** The tile registry: what the tiles are, look like and do. ***/
+/*** BuildTiles() compiles it into the per-character tables below, and ***/
+/*** ReadTiles() adds the tiles of a game. Anything not listed is a ***/
+/*** floor without a glyph. ***/
+struct tiledef
+{
+	char cFirst, cLast;
+	int iFlags;
+	int iW, iH; /*** Glyph; see docs/code_page_437.txt or png/8x16.png. ***/
+	int iColor; /*** 0xRRGGBB ***/
+	int iStep; /*** When the prince steps on it. ***/
+	int iDown; /*** When he presses Arrow Down on it. ***/
+};
+struct tiledef arTileDefs[] = {
+	/*** Should never be used. ***/
+	{' ', ' ', TILE_FLOOR, 16, 4, 0x000000, ACT_NONE, ACT_NONE},
+	/*** Sword. ***/
+	{'!', '!', TILE_FLOOR, 14, 3, 0xaaaaaa, ACT_NONE, ACT_SWORD},
+	/*** Gate (open). ***/
+	{'"', '"', TILE_FLOOR | TILE_GATE, 1, 14, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Wall (inc. floor with tapestry). ***/
+	{'#', '#', TILE_WALL, 12, 14, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Coin on floor. ***/
+	{'$', '$', TILE_FLOOR, 10, 1, 0xffff55, ACT_COIN, ACT_NONE},
+	/*** Mirror. ***/
+	{'%', '%', TILE_WALL, 14, 14, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Custom Puny Prince tile. ***/
+	/* CUSTOM INFO
+	 * Change this line, or better, redefine & in the tiles.txt of a game.
+	 * See ReadTiles().
+	 */
+	{'&', '&', TILE_FLOOR, 16, 4, 0x000000, ACT_NONE, ACT_NONE},
+	/*** Torch on floor (inc. with debris). ***/
+	{'\'', '\'', TILE_FLOOR | TILE_TORCH, 16, 6, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Gate top (inc. tapestry). ***/
+	{'(', '(', TILE_WALL, 10, 12, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Gate (closed). ***/
+	{')', ')', TILE_GATE, 11, 12, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Spikes (in). Harmless. ***/
+	{'*', '*', TILE_FLOOR | TILE_SPIKES | TILE_HAZARD, 16, 6, 0xffffff,
+		ACT_NONE, ACT_NONE},
+	/*** Skeleton. ***/
+	{'+', '+', TILE_FLOOR, 6, 13, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Teleport right. ***/
+	{',', ',', TILE_FLOOR | TILE_TELEPORT, 16, 12, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Debris. ***/
+	{'-', '-', TILE_FLOOR, 16, 6, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Empty. ***/
+	{'.', '.', TILE_EMPTY, 1, 1, 0x000000, ACT_NONE, ACT_NONE},
+	/*** Lattice top. ***/
+	{'/', '/', TILE_EMPTY, 9, 14, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Potion (empty). ***/
+	{'0', '0', TILE_FLOOR | TILE_POTION, 15, 3, 0xaaaaaa, ACT_NONE, ACT_EMPTY},
+	/*** Potion (heal). ***/
+	{'1', '1', TILE_FLOOR | TILE_POTION, 15, 3, 0xaa0000, ACT_NONE, ACT_HEAL},
+	/*** Potion (life). ***/
+	{'2', '2', TILE_FLOOR | TILE_POTION, 11, 4, 0xaa0000, ACT_NONE, ACT_LIFE},
+	/*** Potion (float). ***/
+	{'3', '3', TILE_FLOOR | TILE_POTION, 11, 4, 0x00aa00, ACT_NONE, ACT_FLOAT},
+	/*** Potion (flip). Not yet implemented. ***/
+	{'4', '4', TILE_FLOOR | TILE_POTION, 11, 4, 0x00aa00, ACT_NONE, ACT_NONE},
+	/*** Potion (hurt). ***/
+	{'5', '5', TILE_FLOOR | TILE_POTION, 15, 3, 0x0000aa, ACT_NONE, ACT_HURT},
+	/*** Potion (special blue). ***/
+	{'6', '6', TILE_FLOOR | TILE_POTION, 15, 3, 0x0000aa, ACT_NONE, ACT_BLUE},
+	/*** Sign. ***/
+	{'7', '7', TILE_FLOOR, 15, 16, 0x5555ff, ACT_NONE, ACT_NONE},
+	/*** Fake wall (floor that looks like a wall). ***/
+	{'8', '8', TILE_FLOOR, 12, 14, 0x555555, ACT_REVEAL, ACT_NONE},
+	/*** Fake empty (floor that looks empty). ***/
+	{'9', '9', TILE_FLOOR, 1, 1, 0x000000, ACT_REVEAL, ACT_NONE},
+	/*** Pillar top. ***/
+	{':', ':', TILE_EMPTY, 5, 16, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Pillar bottom. ***/
+	{';', ';', TILE_FLOOR, 6, 16, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Moving platform (hor). ***/
+	{'<', '<', TILE_FLOOR | TILE_PLATFORM, 16, 6, 0xff55ff, ACT_NONE, ACT_NONE},
+	/*** Chomper (closed). ***/
+	{'=', '=', TILE_FLOOR | TILE_CHOMPER | TILE_HAZARD, 9, 14, 0xaaaaaa,
+		ACT_CHOMPER, ACT_NONE},
+	/*** Moving platform (ver). ***/
+	{'>', '>', TILE_FLOOR | TILE_PLATFORM, 16, 6, 0xff55ff, ACT_NONE, ACT_NONE},
+	/*** Converted to - and appears in-game as - empty. ***/
+	{'?', '?', TILE_EMPTY, 16, 4, 0x000000, ACT_NONE, ACT_NONE},
+	/*** Chomper (open). ***/
+	{'@', '@', TILE_FLOOR | TILE_CHOMPER | TILE_HAZARD, 4, 12, 0xaaaaaa,
+		ACT_NONE, ACT_NONE},
+	/*** Raise buttons A - R (18). ***/
+	{'A', 'R', TILE_FLOOR | TILE_BUTTON | TILE_RAISE, 16, 6, 0x55ff55,
+		ACT_BUTTON, ACT_NONE},
+	/*** Teleports left S - Z (8). ***/
+	{'S', 'Z', TILE_FLOOR | TILE_TELEPORT, 11, 14, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Level door left (closed). ***/
+	{'[', '[', TILE_FLOOR | TILE_DOOR, 10, 13, 0x00aaaa, ACT_NONE, ACT_NONE},
+	/*** Lattice (inc. small, left, right). ***/
+	{'\\', '\\', TILE_EMPTY, 16, 13, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Level door right (closed). ***/
+	{']', ']', TILE_FLOOR | TILE_DOOR, 12, 12, 0x00aaaa, ACT_NONE, ACT_NONE},
+	/*** Spikes (out). Harmful. ***/
+	{'^', '^', TILE_FLOOR | TILE_SPIKES | TILE_HAZARD, 15, 2, 0xffffff,
+		ACT_SPIKES, ACT_NONE},
+	/*** Floor (inc. balcony left/right, stuck button). ***/
+	{'_', '_', TILE_FLOOR, 16, 6, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Empty with window. ***/
+	{'`', '`', TILE_EMPTY, 16, 8, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Drop buttons a - r (18). ***/
+	{'a', 'r', TILE_FLOOR | TILE_BUTTON, 16, 6, 0xff5555, ACT_BUTTON, ACT_NONE},
+	/*** Teleports left s - z (8). ***/
+	{'s', 'z', TILE_FLOOR | TILE_TELEPORT, 11, 14, 0xaaaaaa, ACT_NONE, ACT_NONE},
+	/*** Level door left (open). ***/
+	{'{', '{', TILE_FLOOR | TILE_DOOR, 6, 14, 0x00aaaa, ACT_NONE, ACT_NONE},
+	/*** Pillar (inc. for lattice). ***/
+	{'|', '|', TILE_FLOOR, 4, 12, 0x555555, ACT_NONE, ACT_NONE},
+	/*** Level door right (open). ***/
+	{'}', '}', TILE_FLOOR | TILE_DOOR, 9, 12, 0x00aaaa, ACT_NONE, ACT_NONE},
+	/*** Loose floor (inc. stuck). ***/
+	{'~', '~', TILE_FLOOR | TILE_LOOSE, 16, 6, 0x555555, ACT_LOOSE, ACT_NONE}
+};
+Uint16 arTileFlags[256];
+Uint8 arTileGlyph[256][2]; /*** 0 if there is none. ***/
+Uint8 arTileColor[256][3];
+Uint8 arTileStep[256];
+Uint8 arTileDown[256];
+const char *arTileFlagName[TILE_BITS] = {"empty", "floor", "wall", "gate",
+	"door", "button", "raise", "teleport", "loose", "potion", "spikes",
+	"chomper", "hazard", "platform", "torch"};
+const char *arActName[ACTS] = {"-", "spikes", "loose", "button", "chomper",
+	"coin", "reveal", "sword", "empty", "heal", "life", "float", "hurt",
+	"blue"};
+/*** How LEVELS.DAT groups and variants become tiles. If cFirst and ***/
+/*** cLast differ, the tile counts up with the variant. ***/
+struct datdef
+{
+	int iGroup;
+	int iFirst, iLast;
+	char cFirst, cLast;
+};
+struct datdef arDatDefs[] = {
+	{0, 0, 2, '.', '.'}, /*** empty, (no) pattern ***/
+	{0, 3, 3, '`', '`'}, /*** window ***/
+	{0, 255, 255, '.', '.'}, /*** no pattern ***/
+	{1, 0, 3, '_', '_'}, /*** floor, (no) pattern ***/
+	{1, 4, 4, '$', '$'}, /*** coin ***/
+	{1, 5, 5, '8', '8'}, /*** fake wall ***/
+	{1, 6, 6, '9', '9'}, /*** fake empty ***/
+	{1, 7, 7, '7', '7'}, /*** sign ***/
+	{1, 8, 8, '<', '<'}, /*** platform hor ***/
+	{1, 9, 9, '>', '>'}, /*** platform ver ***/
+	{1, 13, 13, '8', '8'}, /*** fake wall ***/
+	{1, 14, 14, '9', '9'}, /*** fake empty ***/
+	{1, 255, 255, '_', '_'}, /*** no pattern ***/
+	{2, 0, 0, '*', '*'}, /*** spikes ***/
+	{2, 1, 4, '^', '^'},
+	{2, 5, 9, '_', '_'},
+	{3, 0, 0, '|', '|'}, /*** pillar ***/
+	{4, 0, 0, ')', ')'}, /*** gate, closed ***/
+	{4, 1, 1, '"', '"'}, /*** open ***/
+	{4, 2, 2, ')', ')'}, /*** closed ***/
+	{5, 0, 0, '_', '_'}, /*** stuck button ***/
+	{6, 0, 255, DAT_BUTTON, DAT_BUTTON}, /*** drop ***/
+	{7, 0, 3, '#', '#'}, /*** tapestry + floor ***/
+	{8, 0, 0, ';', ';'}, /*** pillar bottom ***/
+	{9, 0, 0, ':', ':'}, /*** pillar top ***/
+	{10, 0, 6, '0', '6'}, /*** potions ***/
+	{11, 0, 0, '~', '~'}, /*** loose ***/
+	{12, 0, 7, '(', '('}, /*** gate top ***/
+	{13, 0, 0, '%', '%'}, /*** mirror ***/
+	{14, 0, 0, '-', '-'}, /*** debris ***/
+	{15, 0, 255, DAT_BUTTON, DAT_BUTTON}, /*** raise ***/
+	{16, 0, 0, '[', '['}, /*** level door left ***/
+	{17, 0, 0, ']', ']'}, /*** level door right ***/
+	{18, 0, 0, '@', '@'}, /*** chomper ***/
+	{18, 1, 1, '_', '_'},
+	{18, 2, 2, '#', '#'},
+	{18, 3, 5, '_', '_'},
+	{19, 0, 0, '\'', '\''}, /*** torch ***/
+	{20, 0, 1, '#', '#'}, /*** wall ***/
+	{21, 0, 0, '+', '+'}, /*** skeleton ***/
+	{22, 0, 0, '!', '!'}, /*** sword ***/
+	{23, 0, 0, '_', '_'}, /*** balcony left ***/
+	{23, 1, 8, 'S', 'Z'}, /*** teleports left ***/
+	{23, 9, 16, 's', 'z'}, /*** teleports left ***/
+	{24, 0, 0, '_', '_'}, /*** balcony right ***/
+	{24, 1, 1, ',', ','}, /*** teleport right ***/
+	{25, 0, 0, '|', '|'}, /*** lattice pillar ***/
+	{26, 0, 0, '/', '/'}, /*** lattice top ***/
+	{27, 0, 0, '\\', '\\'}, /*** small lattice ***/
+	{28, 0, 0, '\\', '\\'}, /*** lattice left ***/
+	{29, 0, 0, '\\', '\\'}, /*** lattice right ***/
+	{30, 0, 0, '\'', '\''}, /*** torch + debris ***/
+	{31, 0, 0, '&', '&'}, /*** null ***/
+	{32, 0, 2, '.', '.'}, /*** empty, (no) pattern ***/
+	{32, 3, 3, '`', '`'}, /*** window ***/
+	{32, 255, 255, '.', '.'}, /*** no pattern ***/
+	{43, 0, 0, '~', '~'} /*** stuck loose ***/
+};
+char arDatTile[DAT_GROUPS][256]; /*** 0 if unknown. ***/
+int arBoardFlag[BOARDS] = {TILE_FLOOR, TILE_EMPTY, TILE_SPIKES,
+	TILE_CHOMPER, TILE_LOOSE, TILE_GATE};
 /*** for text ***/
 SDL_Color color_bl = {0x00, 0x00, 0x00, 255};
 SDL_Color color_wh = {0xff, 0xff, 0xff, 255};
@@ -243,15 +867,36 @@ void LoadDAT (int iFd, int iUnkSize);
 void GetAsEightBits (unsigned char cChar, char *sBinary);
 int BitsToInt (char *sString);
 int OpenRead (int iLevel, char cType);
+int OpenOptional (int iLevel, char cType);
 int OpenTrunc (int iLevel, char cType);
 void SavePuny (int iLevel);
 char GetLetter (int iFdE, int iVariant, int iType);
 void GetGames (void);
 void ListGames (void);
 void ShowListGames (void);
+void ReadEvents (int iFd, int iLevel);
+void ReadTriggers (int iLevel);
+void AddTriggers (int iLevel, char *sLine);
+void ReadLevel (int iLevel);
+struct game *NewGame (void);
+void FreeGame (struct game *stFree);
+void UseGame (struct game *stUse);
+void Snapshot (struct snapshot *stSnap);
+int Restore (struct snapshot *stSnap);
+int EncodeDelta (Uint8 *sOld, Uint8 *sNew, Uint8 *sDelta);
+void ApplyDelta (Uint8 *sDelta, Uint8 *sLive);
+void RewindReset (void);
+int RewindFits (int iAt, int iSize);
+void RewindDrop (void);
+void RewindRecord (void);
+void RewindStep (void);
+int RewindBytes (void);
 void LoadLevel (int iLevel, int iLives);
 int ReadLine (int iFd, char *sRetString);
 void RunGame (void);
+void PlayMove (int iDir);
+void PlaySide (int iDir, int iMove);
+void GameTick (void);
 void ShowGame (void);
 void LoadFonts (void);
 void MixAudio (void *unused, Uint8 *stream, int iLen);
@@ -265,46 +910,78 @@ void ShowTile (char cTile, int iX, int iY, int iFade);
 void ShowLiving (char cLiving, int iX, int iY);
 void ShowChar (int iW, int iH, int iR, int iG, int iB,
 	int iX, int iY, int iM, int iZ, int iFade);
-int PopUp (char *sQuestion);
+void PopUp (char *sQuestion);
 void ShowPopUp (char *sQuestion);
+void Message (char *sText);
+void ShowMessage (void);
+int OverlayEvent (SDL_Event *event);
+void CloseOverlay (void);
 void DisplayText (int iX, int iY, char *sText);
-void TryGoLeft (int iTurns);
-void TryGoRight (int iTurns);
+void TryGoSide (int iDir, int iTurns);
+void TryCareful (int iDir);
 void TryGoUp (void);
 void TryGoDown (void);
+void TakeSword (int iCell);
+void TileAction (int iAction, int iCell);
 void ToggleJump (void);
 void ToggleCareful (void);
 void ToggleRunJump (void);
-char GetCharLeft (int iRoom, int iTile);
-char GetCharRight (int iRoom, int iTile);
-char GetCharUp (int iRoom, int iTile);
-char GetCharDown (int iRoom, int iTile);
-char GetCharUpLeft (int iRoom, int iTile);
-char GetCharUpRight (int iRoom, int iTile);
-int GetRoomLeft (int iRoom, int iTile);
-int GetRoomRight (int iRoom, int iTile);
-int GetRoomUp (int iRoom, int iTile);
-int GetRoomDown (int iRoom, int iTile);
-int GetRoomUpLeft (int iRoom, int iTile);
-int GetRoomUpRight (int iRoom, int iTile);
-int GetTileLeft (int iRoom, int iTile);
-int GetTileRight (int iRoom, int iTile);
-int GetTileUp (int iRoom, int iTile);
-int GetTileDown (int iRoom, int iTile);
-int GetTileUpLeft (int iRoom, int iTile);
-int GetTileUpRight (int iRoom, int iTile);
+int NeighbourCell (int iRoom, int iTile, int iDir);
+void BuildNeighbours (void);
+void InitCells (void);
+int Cell (int iRoom, int iTile);
+int PrinceCell (void);
+void SetTile (int iCell, char cChar);
+char GetChar (int iRoom, int iTile, int iDir);
+int GetRoom (int iRoom, int iTile, int iDir);
+int GetTile (int iRoom, int iTile, int iDir);
+void BuildTiles (void);
+void SetTileDef (int iChar, int iFlags, int iW, int iH, int iColor,
+	int iStep, int iDown);
+void ReadTiles (void);
+void UseTiles (void);
+void AddTile (char *sLine);
+int TileFlags (char cChar);
+void BuildBoards (void);
+int FirstTile (Uint32 iBoard);
 int IsEmpty (char cChar);
 int IsFloor (char cChar);
+void BuildHazards (void);
 void GameActions (void);
+void SwordHit (void);
+int AddGuard (int iRoom, int iTile, int iType, int iHP);
+int GuardAt (int iRoom, int iTile);
+int FirstGuard (Uint64 iGuards);
+int LivingGuards (int iRoom);
+void GuardsAttack (int iRoom, int iTile, int iSide, Uint32 iPlayMs);
+void KillGuards (int iRoom);
+void FallPrince (void);
+int InFall (void);
 void PushButton (char cChar, int iForever);
+int RunTriggers (int iEvent, int iRoom, int iTile);
+int RunCode (int iCode, int iRoom, int iTile);
+int TriggerEnds (int iEvent, int iCell);
 void Die (void);
+void StartSequence (int iSeq, int iTicks);
+void RunSequence (void);
+void EndSequence (void);
+int HoldKey (SDL_Event *event);
+void PushHeld (void);
+void QueueMove (int iDir, int iKey, Uint32 iAt);
+void ToggleMoveKey (int iKey);
+int PlayQueued (void);
+void MoveShown (void);
+void ShowLatency (void);
 void BossKey (void);
 void ShowBossKey (void);
 void PreventCPUEating (void);
 void ExMarks (void);
 void OpenURL (char *sURL);
 void PlaySound (char *sFile);
+void Flash (int iR, int iG, int iB);
 void DropLoose (int iRoom, int iTile);
+int LooseAt (int iCell);
+void RunLooseFloors (void);
 void GetOptionValue (char *sArgv, char *sValue);
 void Initialize (void);
 void ShowText (int iLine, char *sText, int iR, int iG, int iB, int iInGame);
@@ -312,10 +989,71 @@ void MovingStarts (void);
 void MovingEnds (void);
 int GetX (int iTile);
 int GetY (int iTile);
+void BuildTeleports (int iLevel);
 void Teleport (char cGoTo);
 void DebugRoom (int iRoom);
 void ViewSign (int iLevel, int iRoom, int iTile);
-void ShowViewSign (SDL_Texture *imgsign, int iWarn);
+void ShowViewSign (void);
+void AddPlatform (int iRoom, int iTile);
+void MovePlatform (int iPlatform);
+void StartGateTimer (int iRoom, int iTile, int iFrames);
+void ScheduleGate (int iGate);
+void UnscheduleGate (int iGate);
+void RunGateTimers (void);
+void InitZobrist (void);
+Uint64 Mix64 (Uint64 iValue);
+Uint64 ZobristTile (int iCell, char cChar);
+Uint64 ZobristGate (int iGate, Uint16 iExpiry);
+Uint64 ZobristGuard (int iGuard);
+Uint64 ZobristFlag (int iFlag, int iValue);
+Uint64 ZobristLoose (int iCell, int iPhase);
+Uint64 HashFull (void);
+Uint64 HashFields (void);
+Uint64 HashGame (void);
+void CheckHash (void);
+Uint64 CompareSwap (Uint64 *iWhere, Uint64 iOld, Uint64 iNew);
+int SeenState (Uint64 iKey, Uint64 iLeft);
+int KnownLeft (Uint32 iSlot, Uint64 iLeft);
+int LeftCovers (Uint64 iLeft, Uint64 iThan);
+Uint64 StateKey (Uint64 *iLeft);
+Uint64 PhaseKey (void);
+Uint64 PhaseTag (void);
+int KnownState (Uint64 iKey, Uint64 iLeft);
+int SolveCheck (void);
+int PlayAction (int iMove);
+int SolveMove (int iMove);
+struct solvenode *AddNode (struct solveworker *stWorker,
+	struct solvenode *stParent, int iMove);
+int SolveQuiet (struct solveworker *stWorker, Uint64 *iSlow);
+void ShiftClock (int iTicks, Uint64 iSlow);
+int SolveAdd (struct solveworker *stWorker, struct solvenode *stParent,
+	int iMove, int iResult, int iShift);
+void SolveNode (struct solveworker *stWorker, struct solvenode *stNode);
+int SolveThread (void *data);
+void SolveRun (struct solveworker **arWorker, int iNrWorkers);
+int SolveLevel (int iLevel);
+int *SolutionMoves (struct solvenode *stGoal, int *iNrSolution);
+int SolveReplay (int *arSolution, int iNrSolution);
+void ShowSolution (int *arSolution, int iNrSolution);
+void SolveLevels (int iLevel);
+void AgentTick (void);
+void AgentStep (int iMove, int iTicks, struct agentstep *stStep);
+void AgentState (struct agentstep *stStep);
+void AgentLevel (int iLevel, struct agentstep *stStep);
+void AgentPrint (struct agentstep *stStep);
+void AgentRun (int iLevel);
+int ReachFlags (int iCell);
+void ReachCell (int iCell);
+void ReachLine (int iCell, int iDir, int iTurns);
+void ReachFall (int iCell);
+void ReachMoves (int iCell);
+void ReachAll (void);
+int ReachTriggers (void);
+int ReachPressed (int iCell);
+int ButtonPressed (int iChar);
+int AnalyzeLevel (int iLevel);
+int AnalyzeLevels (void);
+void Benchmark (void);
 
 /*****************************************************************************/
 int main (int argc, char *argv[])
@@ -326,14 +1064,20 @@ int main (int argc, char *argv[])
 	char sStartLevel[MAX_OPTION + 2];
 	char sMode[MAX_OPTION + 2];
 	char sZoom[MAX_OPTION + 2];
+	int iLevelSet;
 
 	/*** Defaults. ***/
+	iLevelSet = 0;
 	iCheat = 0;
 	iFullscreen = 0;
 	iStartLevel = 1;
 	iMode = 2;
 	iZoom = 2;
 
+	/*** Tables that never change; see also UseTiles(). ***/
+	InitCells();
+	InitZobrist();
+
 	if (argc > 1)
 	{
 		for (iArgLoop = 1; iArgLoop <= argc - 1; iArgLoop++)
@@ -360,6 +1104,36 @@ int main (int argc, char *argv[])
 			{
 				iFullscreen = SDL_WINDOW_FULLSCREEN_DESKTOP;
 			}
+			else if ((strcmp (argv[iArgLoop], "-b") == 0) ||
+				(strcmp (argv[iArgLoop], "--benchmark") == 0))
+			{
+				iBenchmark = 1;
+			}
+			else if ((strcmp (argv[iArgLoop], "-w") == 0) ||
+				(strcmp (argv[iArgLoop], "--nowait") == 0))
+			{
+				iNoWait = 1;
+			}
+			else if ((strcmp (argv[iArgLoop], "-s") == 0) ||
+				(strcmp (argv[iArgLoop], "--solve") == 0))
+			{
+				iSolve = 1;
+			}
+			else if ((strcmp (argv[iArgLoop], "-d") == 0) ||
+				(strcmp (argv[iArgLoop], "--debughash") == 0))
+			{
+				iDebugHash = 1;
+			}
+			else if ((strcmp (argv[iArgLoop], "-a") == 0) ||
+				(strcmp (argv[iArgLoop], "--analyze") == 0))
+			{
+				iAnalyze = 1;
+			}
+			else if ((strcmp (argv[iArgLoop], "-i") == 0) ||
+				(strcmp (argv[iArgLoop], "--agent") == 0))
+			{
+				iAgent = 1;
+			}
 			else if ((strcmp (argv[iArgLoop], "-g") == 0) ||
 				(strcmp (argv[iArgLoop], "--generate") == 0))
 			{
@@ -375,6 +1149,7 @@ int main (int argc, char *argv[])
 				{
 					iStartLevel = 1;
 				}
+				iLevelSet = 1;
 			}
 			else if ((strncmp (argv[iArgLoop], "-m=", 3) == 0) ||
 				(strncmp (argv[iArgLoop], "--mode=", 7) == 0))
@@ -410,6 +1185,29 @@ int main (int argc, char *argv[])
 
 	srand ((unsigned)time(&tm));
 	GetGames();
+	if ((iBenchmark == 1) && (iNrGames != 0))
+	{
+		iGameSel = 1;
+		Benchmark();
+		exit (EXIT_NORMAL);
+	}
+	if ((iSolve != 0) && (iNrGames != 0))
+	{
+		iGameSel = 1;
+		SolveLevels (iLevelSet == 1 ? iStartLevel : 0);
+		exit (EXIT_NORMAL);
+	}
+	if ((iAgent == 1) && (iNrGames != 0))
+	{
+		iGameSel = 1;
+		AgentRun (iStartLevel);
+		exit (EXIT_NORMAL);
+	}
+	if ((iAnalyze == 1) && (iNrGames != 0))
+	{
+		if (AnalyzeLevels() != 0) { exit (EXIT_ERROR); }
+		exit (EXIT_NORMAL);
+	}
 	switch (iNrGames)
 	{
 		case 0:
@@ -442,6 +1240,18 @@ void ShowUsage (void)
 	printf ("  -f,        --fullscreen     start in fullscreen\n");
 	printf ("  -g,        --generate       generate level files from"
 		" LEVELS.DAT\n");
+	printf ("  -b,        --benchmark      time neighbour lookups of the"
+		" first game\n");
+	printf ("  -w,        --nowait         skip the waits after dying and"
+		" such\n");
+	printf ("  -s,        --solve          find the fewest steps for all"
+		" levels (or --level)\n");
+	printf ("  -d,        --debughash      check the state hash every game"
+		" tick\n");
+	printf ("  -a,        --analyze        check that all exits, coins and"
+		" buttons can be reached\n");
+	printf ("  -i,        --agent          play moves from stdin, print"
+		" what happened\n");
 	printf ("  -l=NR,     --level=NR       start in level NR\n");
 	printf ("  -m=MODE,   --mode=MODE      start in mode MODE\n");
 	printf ("  -z=ZOOM,   --zoom=ZOOM      start with zoom ZOOM\n");
@@ -465,6 +1275,7 @@ void Generate (void)
 	/*** Used for looping. ***/
 	int iLoopLevel;
 
+	BuildTiles();
 	iFd = open (FILE_DAT, O_RDONLY);
 	if (iFd == -1)
 	{
@@ -662,6 +1473,19 @@ int OpenRead (int iLevel, char cType)
 	return (iFd);
 }
 /*****************************************************************************/
+int OpenOptional (int iLevel, char cType)
+/*****************************************************************************/
+{
+	/*** Like OpenRead(), but returns -1 if there is no such file. ***/
+
+	char sPathFile[MAX_PATHFILE + 2];
+
+	snprintf (sPathFile, MAX_PATHFILE, "%s%s%s%slevel%02i%c%s",
+		DIR_GAMES, SLASH, arGames[iGameSel], SLASH, iLevel, cType, ".txt");
+
+	return (open (sPathFile, O_RDONLY));
+}
+/*****************************************************************************/
 int OpenTrunc (int iLevel, char cType)
 /*****************************************************************************/
 {
@@ -687,7 +1511,6 @@ void SavePuny (int iLevel)
 	int iFdE, iFdR, iFdS, iFdT;
 	char sToWrite[MAX_TOWRITE + 2];
 	int iGroup, iVariant;
-	int iUnknown;
 	char cWrite;
 	int iFixed;
 	int iLeft, iRight, iUp, iDown;
@@ -712,330 +1535,27 @@ void SavePuny (int iLevel)
 		{
 			iGroup = arGroup[iLoopRoom][iLoopTile];
 			iVariant = arVariant[iLoopRoom][iLoopTile];
-			iUnknown = 0;
-			switch (iGroup)
+			cWrite = 0;
+			if ((iGroup >= 0) && (iGroup < DAT_GROUPS) &&
+				(iVariant >= 0) && (iVariant <= 255))
+				{ cWrite = arDatTile[iGroup][iVariant]; }
+			if (cWrite == DAT_BUTTON)
 			{
-				case 0: case 32: /*** empty ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '.'; break; /*** no pattern ***/
-						case 1: cWrite = '.'; break; /*** pattern ***/
-						case 2: cWrite = '.'; break; /*** pattern ***/
-						case 3: cWrite = '`'; break; /*** window ***/
-						/*** 0x04, 0x05, 0x0C, 0x0D, 0x32, 0x33, 0x34, 0x35 ***/
-						case 255: cWrite = '.'; break; /*** no pattern ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 1: /*** floor ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '_'; break; /*** no pattern ***/
-						case 1: cWrite = '_'; break; /*** pattern ***/
-						case 2: cWrite = '_'; break; /*** pattern ***/
-						case 3: cWrite = '_'; break; /*** pattern ***/
-						case 4: cWrite = '$'; break; /*** coin ***/
-						case 5: cWrite = '8'; break; /*** fake wall ***/
-						case 6: cWrite = '9'; break; /*** fake empty ***/
-						case 7: cWrite = '7'; break; /*** sign ***/
-						case 8: cWrite = '<'; break; /*** platform hor ***/
-						case 9: cWrite = '>'; break; /*** platform ver ***/
-						case 13: cWrite = '8'; break; /*** fake wall ***/
-						case 14: cWrite = '9'; break; /*** fake empty ***/
-						/*** 0x32, 0x33, 0x34, 0x35 ***/
-						case 255: cWrite = '_'; break; /*** no pattern ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 2: /*** spikes ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '*'; break;
-						case 1: cWrite = '^'; break;
-						case 2: cWrite = '^'; break;
-						case 3: cWrite = '^'; break;
-						case 4: cWrite = '^'; break;
-						case 5: cWrite = '_'; break;
-						case 6: cWrite = '_'; break;
-						case 7: cWrite = '_'; break;
-						case 8: cWrite = '_'; break;
-						case 9: cWrite = '_'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 3: /*** pillar ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '|'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 4: /*** gate ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = ')'; break; /*** closed ***/
-						case 1: cWrite = '"'; break; /*** open ***/
-						case 2: cWrite = ')'; break; /*** closed ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 5: /*** stuck button ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '_'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 6: /*** drop ***/
-					cWrite = GetLetter (iFdE, iVariant, 6);
-					break;
-				case 7: /*** tapestry + floor ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '#'; break;
-						case 1: cWrite = '#'; break;
-						case 2: cWrite = '#'; break;
-						case 3: cWrite = '#'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 8: /*** pillar bottom ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = ';'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 9: /*** pillar top ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = ':'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 10: /*** potion ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '0'; break; /*** empty ***/
-						case 1: cWrite = '1'; break; /*** heal ***/
-						case 2: cWrite = '2'; break; /*** life ***/
-						case 3: cWrite = '3'; break; /*** float ***/
-						case 4: cWrite = '4'; break; /*** flip ***/
-						case 5: cWrite = '5'; break; /*** hurt ***/
-						case 6: cWrite = '6'; break; /*** special blue ***/
-						/*** 0x07, 0x08, 0x09, 0x0A, 0x0B ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 11: /*** loose ***/
-					switch (iVariant)
-					{
-						case 0:
-							if ((iLevel == 12) && (iLoopRoom == 8) && (iLoopTile == 13))
-							{
-								/*** Because this would be impossible. ***/
-								printf ("[ WARN ] Level %i: converted loose into floor"
-									" (room %i, tile %i).\n", iLevel, iLoopRoom, iLoopTile);
-								cWrite = '_';
-							} else {
-								cWrite = '~';
-							}
-							break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 12: /*** gate top ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '('; break;
-						case 1: cWrite = '('; break;
-						case 2: cWrite = '('; break;
-						case 3: cWrite = '('; break;
-						case 4: cWrite = '('; break;
-						case 5: cWrite = '('; break;
-						case 6: cWrite = '('; break;
-						case 7: cWrite = '('; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 13: /*** mirror ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '%'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 14: /*** debris ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '-'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 15: /*** raise ***/
-					cWrite = GetLetter (iFdE, iVariant, 15);
-					break;
-				case 16: /*** level door left ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '['; break;
-						/*** 0x20, 0x40, 0xFD, 0xFF ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 17: /*** level door right ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = ']'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 18: /*** chomper ***/
-					switch (iVariant)
-					{
-						case 0:
-							if ((iLoopTile != 1) && (iLoopTile != 11) && (iLoopTile != 21))
-							{
-								cWrite = '@';
-							} else {
-								/*** Because this would be too difficult. ***/
-								printf ("[ WARN ] Level %i: converted chomper into pillar"
-									" (room %i, tile %i).\n", iLevel, iLoopRoom, iLoopTile);
-								cWrite = '|';
-							}
-							break;
-						case 1: cWrite = '_'; break;
-						case 2: cWrite = '#'; break;
-						case 3: cWrite = '_'; break;
-						case 4: cWrite = '_'; break;
-						case 5: cWrite = '_'; break;
-						/*** 0x80, 0x81, 0x82, 0x83, 0x84, 0x85 ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 19: /*** torch ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '\''; break;
-						/*** 0x01-0x3F ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 20: /*** wall ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '#'; break;
-						case 1: cWrite = '#'; break;
-						/*** 0x04, 0x06, 0x0C, 0x0E ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 21: /*** skeleton ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '+'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 22: /*** sword ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '!'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 23: /*** balcony/teleports left ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '_'; break;
-						case 1: cWrite = 'S'; break;
-						case 2: cWrite = 'T'; break;
-						case 3: cWrite = 'U'; break;
-						case 4: cWrite = 'V'; break;
-						case 5: cWrite = 'W'; break;
-						case 6: cWrite = 'X'; break;
-						case 7: cWrite = 'Y'; break;
-						case 8: cWrite = 'Z'; break;
-						case 9: cWrite = 's'; break;
-						case 10: cWrite = 't'; break;
-						case 11: cWrite = 'u'; break;
-						case 12: cWrite = 'v'; break;
-						case 13: cWrite = 'w'; break;
-						case 14: cWrite = 'x'; break;
-						case 15: cWrite = 'y'; break;
-						case 16: cWrite = 'z'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 24: /*** balcony/teleport right ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '_'; break;
-						case 1: cWrite = ','; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 25: /*** lattice pillar ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '|'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 26: /*** lattice top ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '/'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 27: /*** small lattice ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '\\'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 28: /*** lattice left ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '\\'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 29: /*** lattice right ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '\\'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 30: /*** torch + debris ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '\''; break;
-						/*** 0x01-0x3F ***/
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 31: /*** null ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '&'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				case 43: /*** stuck loose ***/
-					switch (iVariant)
-					{
-						case 0: cWrite = '~'; break;
-						default: iUnknown = 1; break;
-					}
-					break;
-				default:
-					iUnknown = 1; break;
+				cWrite = GetLetter (iFdE, iVariant, iGroup);
+			} else if ((cWrite == '~') && (iGroup == 11) && (iLevel == 12) &&
+				(iLoopRoom == 8) && (iLoopTile == 13)) {
+				/*** Because this would be impossible. ***/
+				printf ("[ WARN ] Level %i: converted loose into floor"
+					" (room %i, tile %i).\n", iLevel, iLoopRoom, iLoopTile);
+				cWrite = '_';
+			} else if ((cWrite == '@') && ((iLoopTile == 1) ||
+				(iLoopTile == 11) || (iLoopTile == 21))) {
+				/*** Because this would be too difficult. ***/
+				printf ("[ WARN ] Level %i: converted chomper into pillar"
+					" (room %i, tile %i).\n", iLevel, iLoopRoom, iLoopTile);
+				cWrite = '|';
 			}
-			if (iUnknown == 1)
+			if (cWrite == 0)
 			{
 				if (iLevel != 15)
 				{
@@ -1304,113 +1824,313 @@ void ShowListGames (void)
 	SDL_RenderPresent (ascreen);
 }
 /*****************************************************************************/
-void LoadLevel (int iLevel, int iLives)
+void ReadEvents (int iFd, int iLevel)
 /*****************************************************************************/
 {
-	int iFdE, iFdR, iFdS, iFdT;
-	char sRow1[10 + 2];
-	char sRow2[10 + 2];
-	char sRow3[10 + 2];
-	char sRead[2 + 2];
+	/*** Reads the file twice: first to count the targets per button, ***/
+	/*** then to store them packed in arTargets. ***/
+
 	int iEOF;
 	char sLine[MAX_LINE + 2];
-	char cChar;
+	unsigned char cChar;
 	int iChar;
 	char sRoom[10 + 2]; int iRoom;
 	char sTile[10 + 2]; int iTile;
-	int iEventNr;
-	char sLink[10 + 2];
-	char cCharR1, cCharR2, cCharR3;
+	int arNext[256];
 
 	/*** Used for looping. ***/
-	int iLoopRoom;
-	int iLoopTile;
+	int iLoopPass;
 	int iLoopChar;
 
-	/*** Open files for reading. ***/
-	iFdE = OpenRead (iLevel, 'e');
-	iFdR = OpenRead (iLevel, 'r');
-	iFdS = OpenRead (iLevel, 's');
-	iFdT = OpenRead (iLevel, 't');
+	memset (arNext, 0, sizeof (arNext));
+	for (iLoopPass = 1; iLoopPass <= 2; iLoopPass++)
+	{
+		lseek (iFd, 0, SEEK_SET);
+		do {
+			iEOF = ReadLine (iFd, sLine);
+			if (iEOF == 0)
+			{
+				cChar = sLine[0];
+				for (iChar = 2; iChar < (int)strlen (sLine); iChar+=5)
+				{
+					snprintf (sRoom, 10, "%c%c", sLine[iChar], sLine[iChar + 1]);
+					iRoom = atoi (sRoom);
+					snprintf (sTile, 10, "%c%c", sLine[iChar + 2], sLine[iChar + 3]);
+					iTile = atoi (sTile);
+					if ((iRoom < 1) || (iRoom > ROOMS) ||
+						(iTile < 1) || (iTile > TILES))
+					{
+						if (iLoopPass == 1)
+						{
+							printf ("[ WARN ] Level %i: event %c has no room %i,"
+								" tile %i.\n", iLevel, cChar, iRoom, iTile);
+						}
+						continue;
+					}
+					if (iLoopPass == 1)
+					{
+						arNext[cChar]++;
+					} else {
+						stGame->arTargets[arNext[cChar]] = Cell (iRoom, iTile);
+						arNext[cChar]++;
+					}
+				}
+			}
+		} while (iEOF == 0);
 
-	/*** Events. ***/
-	do {
-		iEOF = ReadLine (iFdE, sLine);
-		if (iEOF == 0)
+		if (iLoopPass == 1)
 		{
-			cChar = sLine[0];
-			iChar = 2;
-			iEventNr = 1;
-			do {
-				snprintf (sRoom, 10, "%c%c", sLine[iChar], sLine[iChar + 1]);
-				iRoom = atoi (sRoom);
-				snprintf (sTile, 10, "%c%c", sLine[iChar + 2], sLine[iChar + 3]);
-				iTile = atoi (sTile);
-				iChar+=5; /*** Including the space. ***/
-				arLettersRoom[(int)cChar][iEventNr] = iRoom;
-				arLettersTile[(int)cChar][iEventNr] = iTile;
-				iEventNr++;
-			} while (iChar < (int)strlen (sLine));
+			/*** Counts to offsets. ***/
+			stGame->arButtonFirst[0] = 0;
+			for (iLoopChar = 0; iLoopChar <= 255; iLoopChar++)
+			{
+				stGame->arButtonFirst[iLoopChar + 1] = stGame->arButtonFirst[iLoopChar] +
+					arNext[iLoopChar];
+				arNext[iLoopChar] = stGame->arButtonFirst[iLoopChar];
+			}
+			if (stGame->arButtonFirst[256] > stGame->iTargetsSize)
+			{
+				stGame->iTargetsSize = stGame->arButtonFirst[256];
+				stGame->arTargets = (Uint16 *)realloc (stGame->arTargets,
+					stGame->iTargetsSize * sizeof (Uint16));
+				if (stGame->arTargets == NULL)
+				{
+					printf ("[FAILED] Could not allocate %i event targets!\n",
+						stGame->iTargetsSize);
+					exit (EXIT_ERROR);
+				}
+			}
 		}
-	} while (iEOF == 0);
+	}
+}
+/*****************************************************************************/
+void ReadTriggers (int iLevel)
+/*****************************************************************************/
+{
+	/*** Reads the special events from levelNNx.txt, or else uses ***/
+	/*** arDefaultTriggers. One trigger per line: ***/
+	/*** <event> <room> <tile> <instruction> [<instruction> ...] ***/
+	/*** The events are in arTrigName; the instructions, with their ***/
+	/*** arguments, in arCodeDefs. Room or tile 0 is any, and the tile may ***/
+	/*** be a range, such as 11-15. An if* instruction ends the trigger if ***/
+	/*** it does not hold. The TRIG_FLAGS flags are 0 when a level starts. ***/
+	/*** For example, these turn a tile into a mirror as soon as the ***/
+	/*** prince is in room 11 after the level door has opened: ***/
+	/*** door 0 0 set 1 1 ***/
+	/*** tick 11 0 ifeq 1 1 tile 4 5 % set 1 2 ***/
 
-	/*** Room links. ***/
-	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	int iFd;
+	int iEOF;
+	char sLine[MAX_LINE + 2];
+	const char *sDefault;
+	int iLength;
+
+	/*** Used for looping. ***/
+	int iLoopTrigger;
+
+	stGame->iNrTriggers = 0;
+	stGame->iCodeSize = 0;
+	iFd = OpenOptional (iLevel, 'x');
+	if (iFd != -1)
 	{
-		ReadLine (iFdR, sLine);
-		snprintf (sLink, 10, "%c%c", sLine[0], sLine[1]);
-		arLinksL[iLoopRoom] = atoi (sLink);
-		snprintf (sLink, 10, "%c%c", sLine[3], sLine[4]);
-		arLinksR[iLoopRoom] = atoi (sLink);
-		snprintf (sLink, 10, "%c%c", sLine[6], sLine[7]);
-		arLinksU[iLoopRoom] = atoi (sLink);
-		snprintf (sLink, 10, "%c%c", sLine[9], sLine[10]);
-		arLinksD[iLoopRoom] = atoi (sLink);
+		do {
+			iEOF = ReadLine (iFd, sLine);
+			AddTriggers (iLevel, sLine);
+		} while (iEOF == 0);
+		close (iFd);
+	} else if ((iLevel >= 1) && (iLevel <= 14)) {
+		sDefault = arDefaultTriggers[iLevel];
+		while (*sDefault != '\0')
+		{
+			iLength = strcspn (sDefault, "\n");
+			snprintf (sLine, MAX_LINE, "%.*s", iLength, sDefault);
+			AddTriggers (iLevel, sLine);
+			sDefault+=iLength;
+			if (*sDefault == '\n') { sDefault++; }
+		}
 	}
 
-	/*** Starting locations. ***/
-	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	memset (stGame->arTrigRooms, 0, sizeof (stGame->arTrigRooms));
+	for (iLoopTrigger = 1; iLoopTrigger <= stGame->iNrTriggers; iLoopTrigger++)
 	{
-		arGuardLoc[iLoopRoom] = 31; /*** disable ***/
+		stGame->arTrigRooms[stGame->arTrigger[iLoopTrigger].iEvent] |=
+			(Uint32)1 << stGame->arTrigger[iLoopTrigger].iRoom;
 	}
-	do {
-		iEOF = ReadLine (iFdS, sLine);
-		if (iEOF == 0)
-		{
-			cChar = sLine[0];
-			snprintf (sRoom, 10, "%c%c", sLine[2], sLine[3]);
-			iRoom = atoi (sRoom);
-			snprintf (sTile, 10, "%c%c", sLine[4], sLine[5]);
-			iTile = atoi (sTile);
-			switch (cChar)
-			{
-				case 'P':
-					iCurRoom = iRoom;
-					iPrinceTile = iTile;
-					break;
-				case 'E':
-					arGuardLoc[iRoom] = iTile;
-					arGuardType[iRoom] = 1;
-					arGuardHP[iRoom] = 3;
-					arGuardAttack[iRoom] = 0;
-					break;
-				case 'H':
-					arGuardLoc[iRoom] = iTile;
-					arGuardType[iRoom] = 2;
-					arGuardHP[iRoom] = 5;
-					arGuardAttack[iRoom] = 0;
-					break;
-				case 'J':
-					arGuardLoc[iRoom] = iTile;
-					arGuardType[iRoom] = 3;
-					arGuardHP[iRoom] = 7;
-					arGuardAttack[iRoom] = 0;
-					break;
-			}
+}
+/*****************************************************************************/
+void AddTriggers (int iLevel, char *sLine)
+/*****************************************************************************/
+{
+	/*** Compiles one line of ReadTriggers() into arTrigCode. ***/
+
+	char sWord[MAX_LINE + 2];
+	int iPos, iRead;
+	int iEvent, iRoom, iFirst, iLast;
+	int iCode, iSize;
+	int iOp;
+	int arArg[3];
+
+	/*** Used for looping. ***/
+	int iLoopArg;
+	int iLoopTile;
+
+	iPos = 0;
+	if ((sscanf (sLine, "%s%n", sWord, &iRead) != 1) ||
+		(sWord[0] == '#')) { return; } /*** Empty, or a comment. ***/
+	iPos+=iRead;
+	for (iEvent = 0; iEvent < TRIG_EVENTS; iEvent++)
+		{ if (strcmp (sWord, arTrigName[iEvent]) == 0) { break; } }
+	iFirst = -1;
+	iLast = -1;
+	if ((iEvent == TRIG_EVENTS) ||
+		(sscanf (sLine + iPos, "%d %s%n", &iRoom, sWord, &iRead) != 2))
+	{
+		printf ("[ WARN ] Level %i: cannot use event \"%s\"!\n", iLevel, sLine);
+		return;
+	}
+	iPos+=iRead;
+	if (sscanf (sWord, "%d-%d", &iFirst, &iLast) == 1) { iLast = iFirst; }
+	if ((iRoom < 0) || (iRoom > ROOMS) || (iFirst < 0) || (iLast > TILES) ||
+		(iFirst > iLast) || ((iFirst == 0) && (iLast != 0)))
+	{
+		printf ("[ WARN ] Level %i: event \"%s\" has no room %i, tile %s!\n",
+			iLevel, sLine, iRoom, sWord);
+		return;
+	}
+
+	/*** The instructions. ***/
+	iCode = stGame->iCodeSize;
+	iSize = iCode;
+	while (sscanf (sLine + iPos, "%s%n", sWord, &iRead) == 1)
+	{
+		iPos+=iRead;
+		for (iOp = 1; iOp < CODES; iOp++)
+			{ if (strcmp (sWord, arCodeDefs[iOp].sName) == 0) { break; } }
+		for (iLoopArg = 0; (iOp < CODES) &&
+			(iLoopArg < arCodeDefs[iOp].iArgs); iLoopArg++)
+		{
+			if (sscanf (sLine + iPos, "%s%n", sWord, &iRead) != 1)
+				{ iOp = CODES; break; }
+			iPos+=iRead;
+			if ((iOp == CODE_TILE) && (iLoopArg == 2))
+			{
+				arArg[iLoopArg] = (unsigned char)sWord[0];
+			} else if (sscanf (sWord, "%d", &arArg[iLoopArg]) != 1) {
+				iOp = CODES;
+			}
+		}
+		if ((iOp == CODES) || ((arCodeDefs[iOp].iCell == 1) &&
+			((arArg[0] < 1) || (arArg[0] > ROOMS) ||
+			(arArg[1] < 1) || (arArg[1] > TILES))) ||
+			((arCodeDefs[iOp].iFlag == 1) &&
+			((arArg[0] < 0) || (arArg[0] >= TRIG_FLAGS))))
+		{
+			printf ("[ WARN ] Level %i: cannot use event \"%s\"!\n",
+				iLevel, sLine);
+			return;
+		}
+		if (iSize + arCodeDefs[iOp].iArgs + 2 > MAX_CODE)
+		{
+			printf ("[ WARN ] Level %i: too many events.\n", iLevel);
+			return;
+		}
+		stGame->arTrigCode[iSize++] = iOp;
+		for (iLoopArg = 0; iLoopArg < arCodeDefs[iOp].iArgs; iLoopArg++)
+			{ stGame->arTrigCode[iSize++] = arArg[iLoopArg]; }
+	}
+	stGame->arTrigCode[iSize++] = CODE_END;
+
+	for (iLoopTile = iFirst; iLoopTile <= iLast; iLoopTile++)
+	{
+		if (stGame->iNrTriggers == MAX_TRIGGERS)
+		{
+			printf ("[ WARN ] Level %i: too many events.\n", iLevel);
+			return;
+		}
+		stGame->iNrTriggers++;
+		stGame->arTrigger[stGame->iNrTriggers].iEvent = iEvent;
+		stGame->arTrigger[stGame->iNrTriggers].iRoom = iRoom;
+		stGame->arTrigger[stGame->iNrTriggers].iTile = iLoopTile;
+		stGame->arTrigger[stGame->iNrTriggers].iCode = iCode;
+	}
+	stGame->iCodeSize = iSize;
+}
+/*****************************************************************************/
+void ReadLevel (int iLevel)
+/*****************************************************************************/
+{
+	int iFdE, iFdR, iFdS, iFdT;
+	char sRow1[10 + 2];
+	char sRow2[10 + 2];
+	char sRow3[10 + 2];
+	char sRead[2 + 2];
+	int iEOF;
+	char sLine[MAX_LINE + 2];
+	char cChar;
+	char sRoom[10 + 2]; int iRoom;
+	char sTile[10 + 2]; int iTile;
+	char sLink[10 + 2];
+	char cCharR1, cCharR2, cCharR3;
+	int iCell;
+	int iGates;
+
+	/*** Used for looping. ***/
+	int iLoopRoom;
+	int iLoopChar;
+
+	UseTiles();
+
+	/*** Open files for reading. ***/
+	iFdE = OpenRead (iLevel, 'e');
+	iFdR = OpenRead (iLevel, 'r');
+	iFdS = OpenRead (iLevel, 's');
+	iFdT = OpenRead (iLevel, 't');
+
+	/*** Events. ***/
+	ReadEvents (iFdE, iLevel);
+	ReadTriggers (iLevel);
+
+	/*** Room links. ***/
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	{
+		ReadLine (iFdR, sLine);
+		snprintf (sLink, 10, "%c%c", sLine[0], sLine[1]);
+		stGame->arLinksL[iLoopRoom] = atoi (sLink);
+		snprintf (sLink, 10, "%c%c", sLine[3], sLine[4]);
+		stGame->arLinksR[iLoopRoom] = atoi (sLink);
+		snprintf (sLink, 10, "%c%c", sLine[6], sLine[7]);
+		stGame->arLinksU[iLoopRoom] = atoi (sLink);
+		snprintf (sLink, 10, "%c%c", sLine[9], sLine[10]);
+		stGame->arLinksD[iLoopRoom] = atoi (sLink);
+	}
+
+	/*** Starting locations. ***/
+	stGame->iNrGuards = 0;
+	memset (stGame->arRoomGuards, 0, sizeof (stGame->arRoomGuards));
+	do {
+		iEOF = ReadLine (iFdS, sLine);
+		if (iEOF == 0)
+		{
+			cChar = sLine[0];
+			snprintf (sRoom, 10, "%c%c", sLine[2], sLine[3]);
+			iRoom = atoi (sRoom);
+			snprintf (sTile, 10, "%c%c", sLine[4], sLine[5]);
+			iTile = atoi (sTile);
+			switch (cChar)
+			{
+				case 'P':
+					stGame->iCurRoom = iRoom;
+					stGame->iPrinceTile = iTile;
+					break;
+				case 'E': AddGuard (iRoom, iTile, 1, 3); break;
+				case 'H': AddGuard (iRoom, iTile, 2, 5); break;
+				case 'J': AddGuard (iRoom, iTile, 3, 7); break;
+			}
 		}
 	} while (iEOF == 0);
 
 	/*** Tiles. ***/
+	stGame->iNrPlatforms = 0;
 	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
 	{
 		read (iFdT, sRow1, 10);
@@ -1422,56 +2142,62 @@ void LoadLevel (int iLevel, int iLives)
 		for (iLoopChar = 1; iLoopChar <= 10; iLoopChar++)
 		{
 			cCharR1 = sRow1[iLoopChar - 1];
-			arTiles[iLoopRoom][iLoopChar] = cCharR1;
+			stGame->arTile[Cell (iLoopRoom, iLoopChar)] = cCharR1;
 			switch (cCharR1)
 			{
 				case '<':
-					arMobBck[iLoopRoom][iLoopChar] = '.';
-					arMobDir[iLoopRoom][iLoopChar] = 2;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar)] = '.';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar)] = TO_RIGHT;
+					AddPlatform (iLoopRoom, iLoopChar);
 					break;
 				case '>':
-					arMobBck[iLoopRoom][iLoopChar] = '.';
-					arMobDir[iLoopRoom][iLoopChar] = 3;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar)] = '.';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar)] = TO_UP;
+					AddPlatform (iLoopRoom, iLoopChar);
 					break;
 				default:
-					arMobBck[iLoopRoom][iLoopChar] = ' ';
-					arMobDir[iLoopRoom][iLoopChar] = 0;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar)] = ' ';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar)] = 0;
 					break;
 			}
 			/***/
 			cCharR2 = sRow2[iLoopChar - 1];
-			arTiles[iLoopRoom][iLoopChar + 10] = cCharR2;
+			stGame->arTile[Cell (iLoopRoom, iLoopChar + 10)] = cCharR2;
 			switch (cCharR2)
 			{
 				case '<':
-					arMobBck[iLoopRoom][iLoopChar + 10] = '.';
-					arMobDir[iLoopRoom][iLoopChar + 10] = 2;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar + 10)] = '.';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar + 10)] = TO_RIGHT;
+					AddPlatform (iLoopRoom, iLoopChar + 10);
 					break;
 				case '>':
-					arMobBck[iLoopRoom][iLoopChar + 10] = '.';
-					arMobDir[iLoopRoom][iLoopChar + 10] = 3;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar + 10)] = '.';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar + 10)] = TO_UP;
+					AddPlatform (iLoopRoom, iLoopChar + 10);
 					break;
 				default:
-					arMobBck[iLoopRoom][iLoopChar + 10] = ' ';
-					arMobDir[iLoopRoom][iLoopChar + 10] = 0;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar + 10)] = ' ';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar + 10)] = 0;
 					break;
 			}
 			/***/
 			cCharR3 = sRow3[iLoopChar - 1];
-			arTiles[iLoopRoom][iLoopChar + 20] = cCharR3;
+			stGame->arTile[Cell (iLoopRoom, iLoopChar + 20)] = cCharR3;
 			switch (cCharR3)
 			{
 				case '<':
-					arMobBck[iLoopRoom][iLoopChar + 20] = '.';
-					arMobDir[iLoopRoom][iLoopChar + 20] = 2;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar + 20)] = '.';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar + 20)] = TO_RIGHT;
+					AddPlatform (iLoopRoom, iLoopChar + 20);
 					break;
 				case '>':
-					arMobBck[iLoopRoom][iLoopChar + 20] = '.';
-					arMobDir[iLoopRoom][iLoopChar + 20] = 3;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar + 20)] = '.';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar + 20)] = TO_UP;
+					AddPlatform (iLoopRoom, iLoopChar + 20);
 					break;
 				default:
-					arMobBck[iLoopRoom][iLoopChar + 20] = ' ';
-					arMobDir[iLoopRoom][iLoopChar + 20] = 0;
+					stGame->arMobBck[Cell (iLoopRoom, iLoopChar + 20)] = ' ';
+					stGame->arMobDir[Cell (iLoopRoom, iLoopChar + 20)] = 0;
 					break;
 			}
 		}
@@ -1482,73 +2208,351 @@ void LoadLevel (int iLevel, int iLives)
 	close (iFdS);
 	close (iFdT);
 
-	/*** Defaults. ***/
-	switch (iLevel)
+	/*** Gates, numbered for their timers. ***/
+	memset (stGame->arGate, 0, sizeof (stGame->arGate));
+	stGame->iNrGates = 0;
+	iGates = 0;
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	{
+		for (iLoopChar = 1; iLoopChar <= TILES; iLoopChar++)
+		{
+			iCell = Cell (iLoopRoom, iLoopChar);
+			if ((stGame->arTile[iCell] != ')') && (stGame->arTile[iCell] != '"'))
+				{ continue; }
+			iGates++;
+			if (iGates <= MAX_GATES)
+			{
+				stGame->arGate[iCell] = iGates;
+				stGame->arGateCell[iGates] = iCell;
+				stGame->iNrGates = iGates;
+			}
+		}
+	}
+	if (iGates > MAX_GATES)
 	{
-		case 1: iPrinceSword = 0; break;
-		default: iPrinceSword = 1; break;
+		printf ("[ WARN ] Level %i has %i gates, only %i can close again!\n",
+			iLevel, iGates, MAX_GATES);
 	}
-	iLevLives = 0;
-	iMaxLives = iLives;
-	iCurLives = iMaxLives;
-	iPrinceHang = 0;
-	iPrinceFloat = 0;
-	iFlash = 0;
-	iPrinceCoins = 0;
 
-	/*** Count total coins. ***/
-	iCoinsInLevel = 0;
-	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	BuildNeighbours();
+	BuildBoards();
+	BuildTeleports (iLevel);
+	stGame->iHazardRoom = 0;
+}
+/*****************************************************************************/
+struct game *NewGame (void)
+/*****************************************************************************/
+{
+	struct game *stNew;
+
+	stNew = calloc (1, sizeof (struct game));
+	if (stNew == NULL)
 	{
-		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+		printf ("[FAILED] Could not allocate a game!\n");
+		exit (EXIT_ERROR);
+	}
+
+	return (stNew);
+}
+/*****************************************************************************/
+void FreeGame (struct game *stFree)
+/*****************************************************************************/
+{
+	if (stGame == stFree) { stGame = &stFirstGame; }
+	free (stFree->arTargets);
+	free (stFree);
+}
+/*****************************************************************************/
+void UseGame (struct game *stUse)
+/*****************************************************************************/
+{
+	/*** From here on, this thread plays stUse. ***/
+
+	stGame = stUse;
+}
+/*****************************************************************************/
+void Snapshot (struct snapshot *stSnap)
+/*****************************************************************************/
+{
+	stSnap->iLevel = stGame->iCurLevel;
+	memcpy (stSnap->sLive, &stGame->arTile, SNAPSHOT_SIZE);
+}
+/*****************************************************************************/
+int Restore (struct snapshot *stSnap)
+/*****************************************************************************/
+{
+	/*** Returns 0 if there is nothing to restore. ***/
+
+	if (stSnap->iLevel == 0) { return (0); }
+
+	/*** ReadLevel() also drops the hazard tables; they follow only the ***/
+	/*** rooms, not the tiles, so they stay good within a level. ***/
+	if (stSnap->iLevel != stGame->iCurLevel) { ReadLevel (stSnap->iLevel); }
+	memcpy (&stGame->arTile, stSnap->sLive, SNAPSHOT_SIZE);
+
+	return (1);
+}
+/*****************************************************************************/
+int EncodeDelta (Uint8 *sOld, Uint8 *sNew, Uint8 *sDelta)
+/*****************************************************************************/
+{
+	/*** Writes the changed runs as: offset (2 bytes), length (2 bytes), ***/
+	/*** the new bytes. A length of 0 ends it. Returns the size. ***/
+
+	int iSize;
+	int iPos, iStart, iLast;
+	Uint16 iOffset, iLength;
+	Uint64 iOld, iNew;
+
+	iSize = 0;
+	iPos = 0;
+	while (iPos < (int)SNAPSHOT_SIZE)
+	{
+		/*** Most of it is the same; skip that a block at a time. ***/
+		if ((iPos + 64 <= (int)SNAPSHOT_SIZE) &&
+			(memcmp (sOld + iPos, sNew + iPos, 64) == 0)) { iPos+=64; continue; }
+		if (iPos + 8 <= (int)SNAPSHOT_SIZE)
+		{
+			memcpy (&iOld, sOld + iPos, 8);
+			memcpy (&iNew, sNew + iPos, 8);
+			if (iOld == iNew) { iPos+=8; continue; }
+		}
+		if (sOld[iPos] == sNew[iPos]) { iPos++; continue; }
+
+		/*** Gaps shorter than a header are taken along. ***/
+		iStart = iPos;
+		iLast = iPos;
+		while ((iPos < (int)SNAPSHOT_SIZE) && (iPos - iLast <= 4))
 		{
-			if (arTiles[iLoopRoom][iLoopTile] == '$') { iCoinsInLevel++; }
-			arGateTimers[iLoopRoom][iLoopTile] = 0;
+			if (sOld[iPos] != sNew[iPos]) { iLast = iPos; }
+			iPos++;
 		}
+		iPos = iLast + 1;
+
+		iOffset = iStart;
+		iLength = iPos - iStart;
+		memcpy (sDelta + iSize, &iOffset, 2);
+		memcpy (sDelta + iSize + 2, &iLength, 2);
+		memcpy (sDelta + iSize + 4, sNew + iStart, iLength);
+		iSize+=4 + iLength;
 	}
+	memset (sDelta + iSize, 0, 4);
+	iSize+=4;
+
+	return (iSize);
+}
+/*****************************************************************************/
+void ApplyDelta (Uint8 *sDelta, Uint8 *sLive)
+/*****************************************************************************/
+{
+	Uint16 iOffset, iLength;
 
-	/*** Special events related. ***/
-	switch (iCurLevel)
+	for (;;)
 	{
-			case 4:
-				iMirror = 0;
-				break;
-			case 6:
-				arGuardLoc[1] = 11;
-				arGuardType[1] = 4;
-				arGuardHP[1] = iMaxLives;
-				arGuardAttack[1] = 0;
-				break;
-			case 7:
-				iPrinceDir = 1;
-				iPrinceHang = 1;
-				break;
-			case 8:
-				iMouse = 0;
-				break;
+		memcpy (&iOffset, sDelta, 2);
+		memcpy (&iLength, sDelta + 2, 2);
+		if (iLength == 0) { break; }
+		memcpy (sLive + iOffset, sDelta + 4, iLength);
+		sDelta+=4 + iLength;
 	}
+}
+/*****************************************************************************/
+void RewindReset (void)
+/*****************************************************************************/
+{
+	iRewindFirst = 0;
+	iRewindNr = 0;
+	iRewindHead = 0;
+	iRewindSinceKey = 0;
+	iRewinding = 0;
+	iRewindMaxUs = 0;
+}
+/*****************************************************************************/
+int RewindFits (int iAt, int iSize)
+/*****************************************************************************/
+{
+	/*** Is arRewind free from iAt, for iSize bytes? iAt is iRewindHead, ***/
+	/*** or 0 if the tick does not fit before the end. ***/
 
-	ShowGame();
+	int iTail;
 
-	if (iCoinsInLevel != 0)
+	if (iRewindNr == 0) { return (1); }
+	iTail = arRewindAt[iRewindFirst];
+	if (iTail < iRewindHead)
 	{
-		snprintf (sMessage, MAX_MESSAGE, "Coins required to raise the exit"
-			" door: %i\n", iCoinsInLevel);
-		SDL_ShowSimpleMessageBox (SDL_MESSAGEBOX_INFORMATION,
-			"Coins", sMessage, window);
+		if (iAt == iRewindHead) { return (1); }
+		return (iSize <= iTail);
+	}
+	if (iAt == iRewindHead) { return (iAt + iSize <= iTail); }
+
+	return (0);
+}
+/*****************************************************************************/
+void RewindDrop (void)
+/*****************************************************************************/
+{
+	/*** Drops the oldest keyframe, with the ticks that build on it. ***/
+
+	do {
+		iRewindFirst = (iRewindFirst + 1) % REWIND_TICKS;
+		iRewindNr--;
+	} while ((iRewindNr > 0) && (arRewindKey[iRewindFirst] == 0));
+}
+/*****************************************************************************/
+void RewindRecord (void)
+/*****************************************************************************/
+{
+	struct snapshot stNow;
+	Uint8 *sData;
+	int iKey, iSize, iAt, iSlot;
+
+	Snapshot (&stNow);
+	iKey = 0;
+	iSize = 0;
+	if ((iRewindNr == 0) || (iRewindSinceKey + 1 >= REWIND_KEY))
+	{
+		iKey = 1;
+	} else {
+		iSize = EncodeDelta (stRewindLast.sLive, stNow.sLive, sRewindDelta);
+	}
+
+	if (iRewindNr == REWIND_TICKS) { RewindDrop(); }
+	for (;;)
+	{
+		if ((iRewindNr == 0) && (iKey == 0)) { iKey = 1; }
+		if (iKey == 1) { iSize = SNAPSHOT_SIZE; }
+		iAt = iRewindHead;
+		if (iAt + iSize > REWIND_BYTES) { iAt = 0; }
+		if (RewindFits (iAt, iSize) == 1) { break; }
+		RewindDrop();
+	}
+	if (iRewindNr == 0) { iAt = 0; }
+
+	if (iKey == 1) { sData = stNow.sLive; } else { sData = sRewindDelta; }
+	memcpy (arRewind + iAt, sData, iSize);
+	iSlot = (iRewindFirst + iRewindNr) % REWIND_TICKS;
+	arRewindAt[iSlot] = iAt;
+	arRewindSize[iSlot] = iSize;
+	arRewindLevel[iSlot] = stNow.iLevel;
+	arRewindKey[iSlot] = iKey;
+	iRewindNr++;
+	iRewindHead = iAt + iSize;
+	if (iKey == 1) { iRewindSinceKey = 0; } else { iRewindSinceKey++; }
+	stRewindLast = stNow;
+}
+/*****************************************************************************/
+void RewindStep (void)
+/*****************************************************************************/
+{
+	/*** Goes back one tick, by playing the ticks after its keyframe. ***/
+
+	Uint64 iStart;
+	int iSlot, iKeyAgo;
+	Uint32 iUs;
+
+	/*** Used for looping. ***/
+	int iLoopAgo;
+
+	if (iRewindNr < 2) { return; }
+	iStart = SDL_GetPerformanceCounter();
+
+	iRewindNr--;
+	iSlot = (iRewindFirst + iRewindNr - 1) % REWIND_TICKS;
+	iRewindHead = arRewindAt[iSlot] + arRewindSize[iSlot];
+
+	iKeyAgo = 0;
+	while (arRewindKey[(iSlot - iKeyAgo + REWIND_TICKS) % REWIND_TICKS] == 0)
+		{ iKeyAgo++; }
+	for (iLoopAgo = iKeyAgo; iLoopAgo >= 0; iLoopAgo--)
+	{
+		iSlot = (iRewindFirst + iRewindNr - 1 - iLoopAgo) % REWIND_TICKS;
+		if (iLoopAgo == iKeyAgo)
+		{
+			memcpy (stRewindLast.sLive, arRewind + arRewindAt[iSlot],
+				SNAPSHOT_SIZE);
+		} else {
+			ApplyDelta (arRewind + arRewindAt[iSlot], stRewindLast.sLive);
+		}
+	}
+	stRewindLast.iLevel = arRewindLevel[iSlot];
+	Restore (&stRewindLast);
+	iRewindSinceKey = iKeyAgo;
+	iNrHeld = 0;
+	iNrMoves = 0;
+
+	iUs = (Uint32)((SDL_GetPerformanceCounter() - iStart) * 1000000 /
+		SDL_GetPerformanceFrequency());
+	if (iUs > iRewindMaxUs) { iRewindMaxUs = iUs; }
+}
+/*****************************************************************************/
+int RewindBytes (void)
+/*****************************************************************************/
+{
+	int iBytes;
+
+	/*** Used for looping. ***/
+	int iLoopTick;
+
+	iBytes = 0;
+	for (iLoopTick = 0; iLoopTick < iRewindNr; iLoopTick++)
+		{ iBytes+=arRewindSize[(iRewindFirst + iLoopTick) % REWIND_TICKS]; }
+
+	return (iBytes);
+}
+/*****************************************************************************/
+void LoadLevel (int iLevel, int iLives)
+/*****************************************************************************/
+{
+
+	/*** Used for looping. ***/
+	int iLoopRoom;
+	int iLoopTile;
+
+	ReadLevel (iLevel);
+
+	/*** Defaults. ***/
+	switch (iLevel)
+	{
+		case 1: stGame->iPrinceSword = 0; break;
+		default: stGame->iPrinceSword = 1; break;
 	}
+	stGame->iLevLives = 0;
+	stGame->iMaxLives = iLives;
+	stGame->iCurLives = stGame->iMaxLives;
+	stGame->iPrinceHang = 0;
+	stGame->iPrinceFall = 0;
+	stGame->iPrinceFloat = 0;
+	stGame->iFlash = 0;
+	stGame->iPrinceCoins = 0;
 
-	/*** Special events related. ***/
-	if (iCurLevel == 1)
+	/*** Count total coins. ***/
+	stGame->iCoinsInLevel = 0;
+	stGame->iGameTick = 0;
+	memset (stGame->arWheel, 0, sizeof (stGame->arWheel));
+	memset (stGame->arWheelSlot, 0, sizeof (stGame->arWheelSlot));
+	stGame->iNrLoose = 0;
+	memset (stGame->arFlag, 0, sizeof (stGame->arFlag));
+	stGame->iHash = HashFull();
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
 	{
-		cChar = arTiles[5][3];
-		if (((cChar >= 'A') && (cChar <= 'R')) ||
-			((cChar >= 'a') && (cChar <= 'r')))
+		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
 		{
-			SDL_Delay (100);
-			PushButton (cChar, 0);
+			if (arTileStep[(unsigned char)stGame->arTile[Cell (iLoopRoom,
+				iLoopTile)]] == ACT_COIN)
+				{ stGame->iCoinsInLevel++; }
 		}
 	}
+
+	RunTriggers (TRIG_START, 0, 0);
+
+	ShowGame();
+
+	if (stGame->iCoinsInLevel != 0)
+	{
+		snprintf (sMessage, MAX_MESSAGE, "Coins required to raise the exit"
+			" door: %i", stGame->iCoinsInLevel);
+		Message (sMessage);
+	}
 }
 /*****************************************************************************/
 int ReadLine (int iFd, char *sRetString)
@@ -1588,223 +2592,82 @@ void RunGame (void)
 {
 	int iGame;
 	SDL_Event event;
-	int iChoice;
-	char cLeft, cRight;
-	int iModRoom, iModTile;
-	char cChar;
-	int iMobMove;
-
-	/*** Used for looping. ***/
-	int iLoopRoom;
-	int iLoopTile;
 
 	iGame = 1;
 
 	/*** Defaults. ***/
-	iJump = 0;
-	iCareful = 0;
-	iRunJump = 0;
-	iCurLevel = iStartLevel;
-	iSteps = 0;
-	iShowStepsCoins = 0;
-	LoadLevel (iCurLevel, START_LIVES);
-	iMobMove = 0;
+	stGame->iJump = 0;
+	stGame->iCareful = 0;
+	stGame->iRunJump = 0;
+	stGame->iCurLevel = iStartLevel;
+	stGame->iSteps = 0;
+	stGame->iShowStepsCoins = 0;
+	stGame->iMobMove = 0;
+	stGame->iSequence = SEQ_NONE;
+	iNrHeld = 0;
+	iNrMoves = 0;
+	iMoveShown = 1;
+	stGame->iPlayTicks = 0;
+	stGame->iSequenceTotal = 0;
+	iOverlay = OVL_NONE;
+	RewindReset();
+	LoadLevel (stGame->iCurLevel, START_LIVES);
 
 	while (iGame == 1)
 	{
-		GameActions();
+		if ((stGame->iSequence == SEQ_NONE) && (iOverlay == OVL_NONE) &&
+			(iRewinding == 0)) { GameActions(); }
 
 		/*** This is for the game animation. ***/
 		newticks = SDL_GetTicks();
 		if (newticks > oldticks + REFRESH_GAME)
 		{
-			iMobMove++; if (iMobMove > 3) { iMobMove = 0; }
-			if (iFlash > 0) { iFlash--; }
-			if (iPrinceFloat > 0) { iPrinceFloat--; }
-			for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+			if (iOverlay == OVL_NONE)
 			{
-				for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+				if (iRewinding == 1)
 				{
-					if (iMobMove == 3)
+					RewindStep();
+				} else {
+					if (stGame->iFlash > 0) { stGame->iFlash--; }
+					if (stGame->iSequence == SEQ_NONE) { PlayQueued(); }
+					if (stGame->iSequence != SEQ_NONE)
 					{
-						if (arTiles[iLoopRoom][iLoopTile] == '<') /*** platform hor ***/
-						{
-							if (arMobDir[iLoopRoom][iLoopTile] == 2) /*** right ***/
-							{
-								if ((GetCharRight (iLoopRoom, iLoopTile) == '.') ||
-									(GetCharRight (iLoopRoom, iLoopTile) == '`'))
-								{
-									arMobBck[GetRoomRight (iLoopRoom, iLoopTile)]
-										[GetTileRight (iLoopRoom, iLoopTile)] =
-										GetCharRight (iLoopRoom, iLoopTile);
-									arMobDir[GetRoomRight (iLoopRoom, iLoopTile)]
-										[GetTileRight (iLoopRoom, iLoopTile)] = 6;
-									arTiles[iLoopRoom][iLoopTile] =
-										arMobBck[iLoopRoom][iLoopTile];
-									arTiles[GetRoomRight (iLoopRoom, iLoopTile)]
-										[GetTileRight (iLoopRoom, iLoopTile)] = '<';
-									if ((iLoopRoom == iCurRoom) && (iLoopTile == iPrinceTile))
-									{
-										iCurRoom = GetRoomRight (iLoopRoom, iLoopTile);
-										iPrinceTile = GetTileRight (iLoopRoom, iLoopTile);
-									}
-								} else {
-									arMobDir[iLoopRoom][iLoopTile] = 5;
-								}
-							} else if (arMobDir[iLoopRoom][iLoopTile] == 1) { /*** left ***/
-								if ((GetCharLeft (iLoopRoom, iLoopTile) == '.') ||
-									(GetCharLeft (iLoopRoom, iLoopTile) == '`'))
-								{
-									arMobBck[GetRoomLeft (iLoopRoom, iLoopTile)]
-										[GetTileLeft (iLoopRoom, iLoopTile)] =
-										GetCharLeft (iLoopRoom, iLoopTile);
-									arMobDir[GetRoomLeft (iLoopRoom, iLoopTile)]
-										[GetTileLeft (iLoopRoom, iLoopTile)] = 5;
-									arTiles[iLoopRoom][iLoopTile] =
-										arMobBck[iLoopRoom][iLoopTile];
-									arTiles[GetRoomLeft (iLoopRoom, iLoopTile)]
-										[GetTileLeft (iLoopRoom, iLoopTile)] = '<';
-									if ((iLoopRoom == iCurRoom) && (iLoopTile == iPrinceTile))
-									{
-										iCurRoom = GetRoomLeft (iLoopRoom, iLoopTile);
-										iPrinceTile = GetTileLeft (iLoopRoom, iLoopTile);
-									}
-								} else {
-									arMobDir[iLoopRoom][iLoopTile] = 6;
-								}
-							}
-						}
-						if (arTiles[iLoopRoom][iLoopTile] == '>') /*** platform ver ***/
-						{
-							if (arMobDir[iLoopRoom][iLoopTile] == 3) /*** up ***/
-							{
-								if ((GetCharUp (iLoopRoom, iLoopTile) == '.') ||
-									(GetCharUp (iLoopRoom, iLoopTile) == '`'))
-								{
-									arMobBck[GetRoomUp (iLoopRoom, iLoopTile)]
-										[GetTileUp (iLoopRoom, iLoopTile)] =
-										GetCharUp (iLoopRoom, iLoopTile);
-									arMobDir[GetRoomUp (iLoopRoom, iLoopTile)]
-										[GetTileUp (iLoopRoom, iLoopTile)] = 7;
-									arTiles[iLoopRoom][iLoopTile] =
-										arMobBck[iLoopRoom][iLoopTile];
-									arTiles[GetRoomUp (iLoopRoom, iLoopTile)]
-										[GetTileUp (iLoopRoom, iLoopTile)] = '>';
-									if ((iLoopRoom == iCurRoom) && (iLoopTile == iPrinceTile))
-									{
-										iCurRoom = GetRoomUp (iLoopRoom, iLoopTile);
-										iPrinceTile = GetTileUp (iLoopRoom, iLoopTile);
-									}
-								} else {
-									arMobDir[iLoopRoom][iLoopTile] = 8;
-								}
-							} else if (arMobDir[iLoopRoom][iLoopTile] == 4) { /*** down ***/
-								if ((GetCharDown (iLoopRoom, iLoopTile) == '.') ||
-									(GetCharDown (iLoopRoom, iLoopTile) == '`'))
-								{
-									arMobBck[GetRoomDown (iLoopRoom, iLoopTile)]
-										[GetTileDown (iLoopRoom, iLoopTile)] =
-										GetCharDown (iLoopRoom, iLoopTile);
-									arMobDir[GetRoomDown (iLoopRoom, iLoopTile)]
-										[GetTileDown (iLoopRoom, iLoopTile)] = 8;
-									arTiles[iLoopRoom][iLoopTile] =
-										arMobBck[iLoopRoom][iLoopTile];
-									arTiles[GetRoomDown (iLoopRoom, iLoopTile)]
-										[GetTileDown (iLoopRoom, iLoopTile)] = '>';
-									if ((iLoopRoom == iCurRoom) && (iLoopTile == iPrinceTile))
-									{
-										iCurRoom = GetRoomDown (iLoopRoom, iLoopTile);
-										iPrinceTile = GetTileDown (iLoopRoom, iLoopTile);
-									}
-								} else {
-									arMobDir[iLoopRoom][iLoopTile] = 7;
-								}
-							}
-						}
-					}
-					/***/
-					if (arGateTimers[iLoopRoom][iLoopTile] > 0)
-					{
-						arGateTimers[iLoopRoom][iLoopTile]--;
-						if (arGateTimers[iLoopRoom][iLoopTile] == 0)
-						{
-							if (arTiles[iLoopRoom][iLoopTile] == '"')
-							{
-								arTiles[iLoopRoom][iLoopTile] = ')';
-								if (iLoopRoom == iCurRoom)
-								{
-									PlaySound ("wav/gate_close_fast.wav");
-								}
-							}
-						}
-					}
-				}
-			}
-			for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
-			{
-				for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
-				{
-					switch (arMobDir[iLoopRoom][iLoopTile])
-					{
-						case 5: arMobDir[iLoopRoom][iLoopTile] = 1; break;
-						case 6: arMobDir[iLoopRoom][iLoopTile] = 2; break;
-						case 7: arMobDir[iLoopRoom][iLoopTile] = 3; break;
-						case 8: arMobDir[iLoopRoom][iLoopTile] = 4; break;
+						RunSequence();
+					} else {
+						GameTick();
 					}
+					RewindRecord();
+					if (iDebugHash == 1) { CheckHash(); }
 				}
 			}
-			/*** Special events related. ***/
-			switch (iCurLevel)
-			{
-				case 4:
-					if ((iCurRoom == 11) && (iMirror == 1))
-					{
-						arTiles[4][5] = '%';
-						iMirror = 2;
-					}
-					break;
-				case 8:
-					if ((iCurRoom == 16) && (iMouse > 0))
-					{
-						iMouse++;
-						if (iMouse > 150)
-						{
-							arGuardLoc[16] = 8;
-							arGuardType[16] = 5;
-							arGuardHP[16] = iMaxLives;
-							arGuardAttack[16] = 0;
-							/***/
-							cChar = arTiles[16][8];
-							if (((cChar >= 'A') && (cChar <= 'R')) ||
-								((cChar >= 'a') && (cChar <= 'r')))
-							{
-								PushButton (cChar, 0);
-							}
-							iMouse = -1;
-						}
-					}
-					break;
-			}
 			ShowGame();
+			MoveShown();
 			oldticks = newticks;
 		}
 
 		while (SDL_PollEvent (&event))
 		{
+			if (iOverlay != OVL_NONE)
+			{
+				iRewinding = 0; /*** Its key up may go to the overlay. ***/
+				if (OverlayEvent (&event) == 1) { iGame = 0; }
+				continue;
+			}
 			switch (event.type)
 			{
 				case SDL_KEYDOWN:
 					if (event.key.repeat == 1)
 					{
-						if (iPrinceSword == 2) { iPrinceSword = 1; }
+						if (stGame->iPrinceSword == 2) { stGame->iPrinceSword = 1; }
 						break;
 					}
+					if ((stGame->iSequence != SEQ_NONE) && (HoldKey (&event) == 1))
+						{ break; }
 					switch (event.key.keysym.sym)
 					{
 						case SDLK_ESCAPE:
 						case SDLK_q:
-							iChoice = PopUp ("Stop playing?");
-							if (iChoice == 1) { iGame = 0; }
+							PopUp ("Stop playing?");
 							break;
 						case SDLK_KP_ENTER:
 						case SDLK_RETURN:
@@ -1814,128 +2677,61 @@ void RunGame (void)
 							{
 								ToggleFullscreen();
 							} else {
-								iShowStepsCoins = 1;
+								stGame->iShowStepsCoins = 1;
 							}
 							break;
-						case SDLK_F9:
-							BossKey();
+						case SDLK_F5:
+							if (stGame->iSequence != SEQ_NONE) { break; }
+							Snapshot (&stQuickSave);
+							Flash (0x55, 0x55, 0x55);
 							break;
-						case SDLK_LEFT:
-							if (iPrinceHang == 2) { break; }
-							MovingStarts();
-							iPrinceDir = 1;
-							if (iRunJump == 1)
+						case SDLK_F8:
+							if (Restore (&stQuickSave) == 1)
 							{
-								TryGoLeft (6);
-							} else if (iJump == 1) {
-								TryGoLeft (3);
-							} else if (iCareful == 1) {
-								cLeft = GetCharLeft (iCurRoom, iPrinceTile);
-								switch (cLeft)
-								{
-									case '~':
-										iModRoom = GetRoomLeft (iCurRoom, iPrinceTile);
-										iModTile = GetTileLeft (iCurRoom, iPrinceTile);
-										DropLoose (iModRoom, iModTile);
-										break;
-									case '.':
-										if ((arTiles[iCurRoom][iPrinceTile] != '<') &&
-											(arTiles[iCurRoom][iPrinceTile] != '>'))
-										{
-											iPrinceHang = 1;
-											iPrinceSafe = 1; /*** In case of spikes below. ***/
-											TryGoLeft (1);
-										}
-										break;
-									case '^':
-										iPrinceSafe = 1;
-										TryGoLeft (1);
-										break;
-								}
-							} else {
-								TryGoLeft (1);
+								iNrHeld = 0;
+								iNrMoves = 0;
+								Flash (0x55, 0x55, 0x55);
 							}
-							MovingEnds();
 							break;
-						case SDLK_RIGHT:
-							if (iPrinceHang == 2) { break; }
-							MovingStarts();
-							iPrinceDir = 2;
-							if (iRunJump == 1)
-							{
-								TryGoRight (6);
-							} else if (iJump == 1) {
-								TryGoRight (3);
-							} else if (iCareful == 1) {
-								cRight = GetCharRight (iCurRoom, iPrinceTile);
-								switch (cRight)
-								{
-									case '~':
-										iModRoom = GetRoomRight (iCurRoom, iPrinceTile);
-										iModTile = GetTileRight (iCurRoom, iPrinceTile);
-										DropLoose (iModRoom, iModTile);
-										break;
-									case '.':
-										if ((arTiles[iCurRoom][iPrinceTile] != '<') &&
-											(arTiles[iCurRoom][iPrinceTile] != '>'))
-										{
-											iPrinceHang = 1;
-											iPrinceSafe = 1; /*** In case of spikes below. ***/
-											TryGoRight (1);
-										}
-										break;
-									case '^':
-										iPrinceSafe = 1;
-										TryGoRight (1);
-										break;
-								}
-							} else {
-								TryGoRight (1);
-							}
-							MovingEnds();
+						case SDLK_F9:
+							BossKey();
 							break;
-						case SDLK_UP:
-							MovingStarts();
-							TryGoUp();
-							MovingEnds();
+						case SDLK_BACKSPACE:
+							iRewinding = 1;
 							break;
+						/*** Moves are shown after their game tick. ***/
+						case SDLK_LEFT:
+							QueueMove (TO_LEFT, 0, event.key.timestamp);
+							continue;
+						case SDLK_RIGHT:
+							QueueMove (TO_RIGHT, 0, event.key.timestamp);
+							continue;
+						case SDLK_UP:
+							QueueMove (TO_UP, 0, event.key.timestamp);
+							continue;
 						case SDLK_DOWN:
-							MovingStarts();
-							iCareful = 0; /*** Spikes always hurt. ***/
-							TryGoDown();
-							MovingEnds();
-							break;
+							QueueMove (TO_DOWN, 0, event.key.timestamp);
+							continue;
 						case SDLK_a:
 							if ((event.key.keysym.mod & KMOD_LCTRL) ||
 								(event.key.keysym.mod & KMOD_RCTRL))
 							{
 								/*** Restart iCurLevel. ***/
-								LoadLevel (iCurLevel, iMaxLives - iLevLives);
+								LoadLevel (stGame->iCurLevel,
+									stGame->iMaxLives - stGame->iLevLives);
 							}
 							break;
 						case SDLK_c:
-							ToggleCareful();
+							QueueMove (0, MOVE_CAREFUL, event.key.timestamp);
 							break;
 						case SDLK_j:
-							ToggleJump();
+							QueueMove (0, MOVE_JUMP, event.key.timestamp);
 							break;
 						case SDLK_k:
 							if (iCheat == 1)
 							{
-								arGuardHP[iCurRoom] = 0;
 								PlaySound ("wav/hit_guard.wav");
-								/*** Special events related. ***/
-								if ((iCurLevel == 13) && (arGuardType[iCurRoom] == 3))
-								{
-									cChar = arTiles[24][1];
-									if (((cChar >= 'A') && (cChar <= 'R')) ||
-										((cChar >= 'a') && (cChar <= 'r')))
-									{
-										PushButton (cChar, 0);
-									}
-									iFlash = 10;
-									iFlashR = 0xff; iFlashG = 0xff; iFlashB = 0xff;
-								}
+								KillGuards (stGame->iCurRoom);
 							}
 							break;
 						case SDLK_l:
@@ -1944,10 +2740,11 @@ void RunGame (void)
 							{
 								if (iCheat == 1)
 								{
-									if (iCurLevel < 14)
+									if (stGame->iCurLevel < 14)
 									{
-										iCurLevel++;
-										LoadLevel (iCurLevel, iMaxLives);
+										stGame->iCurLevel++;
+										LoadLevel (stGame->iCurLevel,
+											stGame->iMaxLives);
 									}
 								}
 							}
@@ -1960,15 +2757,15 @@ void RunGame (void)
 							if ((event.key.keysym.mod & KMOD_LCTRL) ||
 								(event.key.keysym.mod & KMOD_RCTRL))
 							{
-								iSteps = 0;
-								iCurLevel = 1;
-								LoadLevel (iCurLevel, START_LIVES);
+								stGame->iSteps = 0;
+								stGame->iCurLevel = 1;
+								LoadLevel (stGame->iCurLevel, START_LIVES);
 							} else {
-								ToggleRunJump();
+								QueueMove (0, MOVE_RUNJUMP, event.key.timestamp);
 							}
 							break;
 						case SDLK_s:
-							if (iPrinceSword == 1) { iPrinceSword = 2; }
+							if (stGame->iPrinceSword == 1) { stGame->iPrinceSword = 2; }
 							break;
 						case SDLK_t:
 							if ((event.key.keysym.mod & KMOD_LSHIFT) ||
@@ -1976,20 +2773,20 @@ void RunGame (void)
 							{
 								if (iCheat == 1)
 								{
-									if (iMaxLives < 10)
+									if (stGame->iMaxLives < 10)
 									{
-										iMaxLives++;
-										iCurLives = iMaxLives;
-										iFlash = 10;
-										iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
+										stGame->iMaxLives++;
+										stGame->iCurLives = stGame->iMaxLives;
+										Flash (0xaa, 0x00, 0x00);
 									}
 								}
 							}
 							break;
 						case SDLK_v:
-							if (arTiles[iCurRoom][iPrinceTile] == '7')
+							if (stGame->arTile[PrinceCell()] == '7')
 							{
-								ViewSign (iCurLevel, iCurRoom, iPrinceTile);
+								ViewSign (stGame->iCurLevel, stGame->iCurRoom,
+									stGame->iPrinceTile);
 							}
 							break;
 						case SDLK_w:
@@ -1998,9 +2795,8 @@ void RunGame (void)
 							{
 								if (iCheat == 1)
 								{
-									iPrinceFloat+=50;
-									iFlash = 10;
-									iFlashR = 0x00; iFlashG = 0xaa; iFlashB = 0x00;
+									stGame->iPrinceFloat+=50;
+									Flash (0x00, 0xaa, 0x00);
 								}
 							}
 							break;
@@ -2015,7 +2811,10 @@ void RunGame (void)
 					switch (event.key.keysym.sym)
 					{
 						case SDLK_s:
-							if (iPrinceSword == 2) { iPrinceSword = 1; }
+							if (stGame->iPrinceSword == 2) { stGame->iPrinceSword = 1; }
+							break;
+						case SDLK_BACKSPACE:
+							iRewinding = 0;
 							break;
 					}
 					ShowGame();
@@ -2078,14 +2877,102 @@ void RunGame (void)
 					if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
 						{ ShowGame(); } break;
 				case SDL_QUIT:
-					iChoice = PopUp ("Stop playing?");
-					if (iChoice == 1) { iGame = 0; }
+					PopUp ("Stop playing?");
 					break;
 			}
 		}
 
 		PreventCPUEating();
 	}
+
+	printf ("[ INFO ] Played %lu game ticks, plus %lu in sequences.\n",
+		(unsigned long)stGame->iPlayTicks, (unsigned long)stGame->iSequenceTotal);
+	printf ("[ INFO ] Rewind kept %i game ticks in %i KB; a step back took"
+		" up to %lu us.\n", iRewindNr, RewindBytes() / 1024,
+		(unsigned long)iRewindMaxUs);
+	ShowLatency();
+}
+/*****************************************************************************/
+void PlayMove (int iDir)
+/*****************************************************************************/
+{
+	/*** An arrow key, in the mode (jump, careful, ...) that is on. ***/
+
+	switch (iDir)
+	{
+		case TO_LEFT:
+		case TO_RIGHT:
+			if (stGame->iRunJump == 1)
+			{
+				PlaySide (iDir, MOVE_RUNJUMP);
+			} else if (stGame->iJump == 1) {
+				PlaySide (iDir, MOVE_JUMP);
+			} else if (stGame->iCareful == 1) {
+				PlaySide (iDir, MOVE_CAREFUL);
+			} else {
+				PlaySide (iDir, MOVE_WALK);
+			}
+			break;
+		case TO_UP:
+			if (stGame->iPrinceFall == 1) { break; }
+			MovingStarts();
+			TryGoUp();
+			MovingEnds();
+			break;
+		case TO_DOWN:
+			if (stGame->iPrinceFall == 1) { break; }
+			MovingStarts();
+			stGame->iCareful = 0; /*** Spikes always hurt. ***/
+			TryGoDown();
+			MovingEnds();
+			break;
+	}
+}
+/*****************************************************************************/
+void PlaySide (int iDir, int iMove)
+/*****************************************************************************/
+{
+	/*** A move to TO_LEFT or TO_RIGHT. Sets the mode of iMove, so that ***/
+	/*** triggers see it, and clears it after, as the keys would. ***/
+
+	if ((stGame->iPrinceHang == 2) || (stGame->iPrinceFall == 1)) { return; }
+	MovingStarts();
+	stGame->iPrinceDir = iDir; /*** 1 = left, 2 = right ***/
+	stGame->iJump = (iMove == MOVE_JUMP);
+	stGame->iCareful = (iMove == MOVE_CAREFUL);
+	stGame->iRunJump = (iMove == MOVE_RUNJUMP);
+	if (iMove == MOVE_CAREFUL)
+	{
+		TryCareful (iDir);
+	} else {
+		TryGoSide (iDir, iMove);
+	}
+	MovingEnds();
+}
+/*****************************************************************************/
+void GameTick (void)
+/*****************************************************************************/
+{
+
+	/*** Used for looping. ***/
+	int iLoopPlatform;
+
+	stGame->iPlayTicks++;
+	stGame->iMobMove++; if (stGame->iMobMove > 3) { stGame->iMobMove = 0; }
+	if (stGame->iPrinceFloat > 0) { stGame->iPrinceFloat--; }
+	if (stGame->iNrPlatforms != 0) { iSolveClock = 1; }
+	if (stGame->iMobMove == 3)
+	{
+		for (iLoopPlatform = 1; iLoopPlatform <= stGame->iNrPlatforms;
+			iLoopPlatform++)
+		{
+			MovePlatform (iLoopPlatform);
+		}
+	}
+	RunGateTimers();
+	RunLooseFloors();
+	FallPrince();
+	RunTriggers (TRIG_TICK, stGame->iCurRoom, stGame->iPrinceTile);
 }
 /*****************************************************************************/
 void ShowGame (void)
@@ -2095,12 +2982,15 @@ void ShowGame (void)
 	int iStartX, iStartY;
 	char sSteps[10 + 2], sCoins[10 + 2];
 	int iSwordRoom, iSwordTile;
-	char cChar;
+	int iGuard;
 
 	/*** Used for looping. ***/
 	int iLoopTile;
 	int iLoopLives;
 
+	if (iHeadless == 1) { return; }
+	if (iOverlay == OVL_BOSSKEY) { ShowBossKey(); return; }
+
 	ShowImage (imgscreeng, 0, 0, "imgscreeng");
 	ShowImage (imgblack, 102, 8, "imgblack");
 
@@ -2110,77 +3000,66 @@ void ShowGame (void)
 	iStartY = 8 + ((560 - (arHeight[iMode] * 3 * iZoom)) / 2);
 
 	/*** iSwordRoom & iSwordTile ***/
-	if (iPrinceDir == 1)
+	if (stGame->iPrinceDir == 1)
 	{
-		iSwordRoom = GetRoomLeft (iCurRoom, iPrinceTile);
-		iSwordTile = GetTileLeft (iCurRoom, iPrinceTile);
+		iSwordRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+		iSwordTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
 	} else {
-		iSwordRoom = GetRoomRight (iCurRoom, iPrinceTile);
-		iSwordTile = GetTileRight (iCurRoom, iPrinceTile);
+		iSwordRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
+		iSwordTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
 	}
 
 	/*** Flash. ***/
-	if (iFlash > 0)
+	if (stGame->iFlash > 0)
 	{
 		iX = iStartX + (-1 * (arWidth[iMode] * iZoom));
 		iY = iStartY + (-1 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iY = iStartY + (0 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iY = iStartY + (1 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iY = iStartY + (2 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iX = iStartX + (11 * (arWidth[iMode] * iZoom));
 		iY = iStartY + (-1 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iY = iStartY + (0 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iY = iStartY + (1 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 		iY = iStartY + (2 * (arHeight[iMode] * iZoom));
-		ShowChar (12, 14, iFlashR, iFlashG, iFlashB, iX, iY, iMode, iZoom, 0);
+		ShowChar (12, 14, stGame->iFlashR, stGame->iFlashG, stGame->iFlashB, iX,
+			iY, iMode, iZoom, 0);
 	}
 
 	/*** Left of room. ***/
 	iX = iStartX + (0 * (arWidth[iMode] * iZoom));
 	iY = iStartY + (0 * (arHeight[iMode] * iZoom));
-	if (arLinksL[iCurRoom] != 0)
-	{
-		ShowTile (arTiles[arLinksL[iCurRoom]][10], iX, iY, 1);
-	} else {
-		ShowTile ('#', iX, iY, 1);
-	}
+	ShowTile (stGame->arTile[Cell (stGame->iCurRoom, 1) - 1], iX, iY, 1);
 	iY = iStartY + (1 * (arHeight[iMode] * iZoom));
-	if (arLinksL[iCurRoom] != 0)
-	{
-		ShowTile (arTiles[arLinksL[iCurRoom]][20], iX, iY, 1);
-	} else {
-		ShowTile ('#', iX, iY, 1);
-	}
+	ShowTile (stGame->arTile[Cell (stGame->iCurRoom, 11) - 1], iX, iY, 1);
 	iY = iStartY + (2 * (arHeight[iMode] * iZoom));
-	if (arLinksL[iCurRoom] != 0)
-	{
-		ShowTile (arTiles[arLinksL[iCurRoom]][30], iX, iY, 1);
-	} else {
-		ShowTile ('#', iX, iY, 1);
-	}
+	ShowTile (stGame->arTile[Cell (stGame->iCurRoom, 21) - 1], iX, iY, 1);
 
 	/*** Above room. ***/
 	iY = iStartY + (-1 * (arHeight[iMode] * iZoom));
 	for (iLoopTile = 1; iLoopTile <= 10; iLoopTile++)
 	{
-		if (iShowStepsCoins == 0)
+		if (stGame->iShowStepsCoins == 0)
 		{
 			iX = iStartX + (iLoopTile * (arWidth[iMode] * iZoom));
-			if (arLinksU[iCurRoom] != 0)
-			{
-				ShowTile (arTiles[arLinksU[iCurRoom]][iLoopTile + 20], iX, iY, 1);
-			} else {
-				ShowTile ('#', iX, iY, 1);
-			}
+			ShowTile (stGame->arTile[Cell (stGame->iCurRoom, iLoopTile) - ROOM_W],
+				iX, iY, 1);
 		} else {
-			snprintf (sSteps, 10, " S:%i", iSteps);
+			snprintf (sSteps, 10, " S:%i", stGame->iSteps);
 			ShowText (1, sSteps, 0xaa, 0xaa, 0xaa, 1);
 		}
 	}
@@ -2203,36 +3082,17 @@ void ShowGame (void)
 			iX = iStartX + ((iLoopTile - 20) * (arWidth[iMode] * iZoom));
 			iY = iStartY + (2 * (arHeight[iMode] * iZoom));
 		}
-		if (iPrinceTile == iLoopTile)
+		if (stGame->iPrinceTile == iLoopTile)
 		{
 			ShowLiving ('P', iX, iY);
-		} else if ((iPrinceSword == 2) && (iSwordRoom == iCurRoom) &&
+		} else if ((stGame->iPrinceSword == 2) &&
+			(iSwordRoom == stGame->iCurRoom) &&
 			(iSwordTile == iLoopTile)) {
 			ShowTile ('!', iX, iY, 0);
-			if ((arGuardLoc[iSwordRoom] == iSwordTile) &&
-				(arGuardHP[iSwordRoom] != 0))
-			{
-				arGuardHP[iSwordRoom]--;
-				PlaySound ("wav/hit_guard.wav");
-				iPrinceSword = 1;
-				/*** Special events related. ***/
-				if ((iCurLevel == 13) && (arGuardHP[iSwordRoom] == 0)
-					&& (arGuardType[iSwordRoom] == 3))
-				{
-					cChar = arTiles[24][1];
-					if (((cChar >= 'A') && (cChar <= 'R')) ||
-						((cChar >= 'a') && (cChar <= 'r')))
-					{
-						PushButton (cChar, 0);
-					}
-					iFlash = 10;
-					iFlashR = 0xff; iFlashG = 0xff; iFlashB = 0xff;
-				}
-			}
-		} else if (arGuardLoc[iCurRoom] == iLoopTile) {
-			if (arGuardHP[iCurRoom] != 0)
+		} else if ((iGuard = GuardAt (stGame->iCurRoom, iLoopTile)) != -1) {
+			if (stGame->arGuardHP[iGuard] != 0)
 			{
-				switch (arGuardType[iCurRoom])
+				switch (stGame->arGuardType[iGuard])
 				{
 					case 1: ShowLiving ('E', iX, iY); break;
 					case 2: ShowLiving ('H', iX, iY); break;
@@ -2243,23 +3103,28 @@ void ShowGame (void)
 			} else {
 				ShowLiving ('+', iX, iY);
 			}
+		} else if (LooseAt (Cell (stGame->iCurRoom, iLoopTile)) == 1) {
+			ShowTile ('~', iX, iY, 0);
 		} else {
-			ShowTile (arTiles[iCurRoom][iLoopTile], iX, iY, 0);
+			ShowTile (stGame->arTile[Cell (stGame->iCurRoom, iLoopTile)], iX,
+				iY, 0);
 		}
 	}
 
 	/*** Lives. ***/
-	if (iShowStepsCoins == 0)
+	if (stGame->iSequence == SEQ_VICTORY)
 	{
-		if (arTiles[iCurRoom][iPrinceTile] == '7')
+		ShowText (5, " Victory!", 0xaa, 0xaa, 0xaa, 1);
+	} else if (stGame->iShowStepsCoins == 0) {
+		if (stGame->arTile[PrinceCell()] == '7')
 		{
 			ShowText (5, " [V]iew sign", 0xaa, 0xaa, 0xaa, 1);
 		} else {
 			iY = iStartY + (3 * (arHeight[iMode] * iZoom));
-			for (iLoopLives = 1; iLoopLives <= iMaxLives; iLoopLives++)
+			for (iLoopLives = 1; iLoopLives <= stGame->iMaxLives; iLoopLives++)
 			{
 				iX = iStartX + ((iLoopLives - 1) * (arWidth[iMode] * iZoom));
-				if (iCurLives >= iLoopLives)
+				if (stGame->iCurLives >= iLoopLives)
 				{
 					ShowChar (1, 2, 0xaa, 0x00, 0x00, iX, iY, iMode, iZoom, 0);
 				} else {
@@ -2268,25 +3133,32 @@ void ShowGame (void)
 			}
 		}
 	} else {
-		snprintf (sCoins, 10, " C:%i/%i", iPrinceCoins, iCoinsInLevel);
+		snprintf (sCoins, 10, " C:%i/%i", stGame->iPrinceCoins,
+			stGame->iCoinsInLevel);
 		ShowText (5, sCoins, 0xaa, 0xaa, 0xaa, 1);
 	}
 
 	/*** Jump, careful, or runjump. ***/
-	if ((iJump == 1) || (iCareful == 1) || (iRunJump == 1))
+	if ((stGame->iJump == 1) || (stGame->iCareful == 1) || (stGame->iRunJump == 1))
 	{
 		iY = iStartY + (3 * (arHeight[iMode] * iZoom));
 		iX = iStartX + (10 * (arWidth[iMode] * iZoom));
-		if (iJump == 1)
+		if (stGame->iJump == 1)
 			{ ShowChar (11, 5, 0xaa, 0xaa, 0xaa, iX, iY, iMode, iZoom, 0); }
-		if (iCareful == 1)
+		if (stGame->iCareful == 1)
 			{ ShowChar (4, 5, 0xaa, 0xaa, 0xaa, iX, iY, iMode, iZoom, 0); }
-		if (iRunJump == 1)
+		if (stGame->iRunJump == 1)
 			{ ShowChar (3, 6, 0xaa, 0xaa, 0xaa, iX, iY, iMode, iZoom, 0); }
 	}
 
-	/*** refresh screen ***/
-	SDL_RenderPresent (ascreen);
+	/*** Overlays refresh the screen themselves. ***/
+	switch (iOverlay)
+	{
+		case OVL_MESSAGE: ShowMessage(); break;
+		case OVL_POPUP: ShowPopUp (sOverlay); break;
+		case OVL_SIGN: ShowViewSign(); break;
+		default: SDL_RenderPresent (ascreen); break;
+	}
 }
 /*****************************************************************************/
 void LoadFonts (void)
@@ -2389,224 +3261,17 @@ void ToggleFullscreen (void)
 void ShowTile (char cTile, int iX, int iY, int iFade)
 /*****************************************************************************/
 {
-	int iW, iH;
-	int iR, iG, iB;
-	int iShowBack, iYellowBack;
+	int iChar;
+	int iShowBack;
 
-	iYellowBack = 0;
-	switch (cTile)
+	iChar = (unsigned char)cTile;
+	if (arTileGlyph[iChar][0] == 0)
 	{
-		case ' ': /*** should never be used ***/
-			iW = 16; iH = 4;
-			iR = 0x00; iG = 0x00; iB = 0x00;
-			break;
-		case '!': /*** Sword. ***/
-			iW = 14; iH = 3;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '"': /*** Gate (open). ***/
-			iW = 1; iH = 14;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '#': /*** Wall (inc. floor with tapestry). ***/
-			iW = 12; iH = 14;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '$': /*** Coin on floor. ***/
-			iW = 10; iH = 1;
-			iR = 0xff; iG = 0xff; iB = 0x55;
-			break;
-		case '%': /*** Mirror. ***/
-			iW = 14; iH = 14;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '&': /*** Custom Puny Prince tile. ***/
-			/* CUSTOM INFO
-			 * Modify iW (width) and iH (height) to change the ASCII character.
-			 * See docs/code_page_437.txt or png/8x16.png for an overview.
-			 * Modify iR, iG and iB to to change the RGB character color.
-			 */
-			iW = 16; iH = 4;
-			iR = 0x00; iG = 0x00; iB = 0x00;
-			break;
-		case '\'': /*** Torch on floor (inc. with debris). ***/
-			iYellowBack = 1;
-			iW = 16; iH = 6;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '(': /*** Gate top (inc. tapestry). ***/
-			iW = 10; iH = 12;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case ')': /*** Gate (closed). ***/
-			iW = 11; iH = 12;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '*': /*** Spikes (in). Harmless. ***/
-			iW = 16; iH = 6;
-			iR = 0xff; iG = 0xff; iB = 0xff;
-			break;
-		case '+': /*** Skeleton. ***/
-			iW = 6; iH = 13;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case ',': /*** Teleport right. ***/
-			iW = 16; iH = 12;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '-': /*** Debris. ***/
-			iW = 16; iH = 6;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '.': /*** Empty. ***/
-			iW = 1; iH = 1;
-			iR = 0x00; iG = 0x00; iB = 0x00;
-			break;
-		case '/': /*** Lattice top. ***/
-			iW = 9; iH = 14;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '0': /*** Potion (empty). ***/
-			iW = 15; iH = 3;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '1': /*** Potion (heal). ***/
-			iW = 15; iH = 3;
-			iR = 0xaa; iG = 0x00; iB = 0x00;
-			break;
-		case '2': /*** Potion (life). ***/
-			iW = 11; iH = 4;
-			iR = 0xaa; iG = 0x00; iB = 0x00;
-			break;
-		case '3': /*** Potion (float). ***/
-			iW = 11; iH = 4;
-			iR = 0x00; iG = 0xaa; iB = 0x00;
-			break;
-		case '4': /*** Potion (flip). ***/
-			iW = 11; iH = 4;
-			iR = 0x00; iG = 0xaa; iB = 0x00;
-			break;
-		case '5': /*** Potion (hurt). ***/
-			iW = 15; iH = 3;
-			iR = 0x00; iG = 0x00; iB = 0xaa;
-			break;
-		case '6': /*** Potion (special blue). ***/
-			iW = 15; iH = 3;
-			iR = 0x00; iG = 0x00; iB = 0xaa;
-			break;
-		case '7': /*** Sign. ***/
-			iW = 15; iH = 16;
-			iR = 0x55; iG = 0x55; iB = 0xff;
-			break;
-		case '8': /*** Fake wall (floor that looks like a wall). ***/
-			iW = 12; iH = 14;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '9': /*** Fake empty (floor that looks empty). ***/
-			iW = 1; iH = 1;
-			iR = 0x00; iG = 0x00; iB = 0x00;
-			break;
-		case ':': /*** Pillar top. ***/
-			iW = 5; iH = 16;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case ';': /*** Pillar bottom. ***/
-			iW = 6; iH = 16;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '<': /*** Moving platform (hor). ***/
-			iW = 16; iH = 6;
-			iR = 0xff; iG = 0x55; iB = 0xff;
-			break;
-		case '=': /*** Chomper (closed). ***/
-			iW = 9; iH = 14;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '>': /*** Moving platform (ver). ***/
-			iW = 16; iH = 6;
-			iR = 0xff; iG = 0x55; iB = 0xff;
-			break;
-		case '?': /*** Converted to - and appears in-game as - empty. ***/
-			iW = 16; iH = 4;
-			iR = 0x00; iG = 0x00; iB = 0x00;
-			break;
-		case '@': /*** Chomper (open). ***/
-			iW = 4; iH = 12;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-		case 'G': case 'H': case 'I': case 'J': case 'K': case 'L':
-		case 'M': case 'N': case 'O': case 'P': case 'Q': case 'R':
-			/*** Raise buttons A - R (18). ***/
-			iW = 16; iH = 6;
-			iR = 0x55; iG = 0xff; iB = 0x55;
-			break;
-		case 'S': case 'T': case 'U': case 'V':
-		case 'W': case 'X': case 'Y': case 'Z':
-			/*** Teleports left S - Z (8). ***/
-			iW = 11; iH = 14;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '[': /*** Level door left (closed). ***/
-			iW = 10; iH = 13;
-			iR = 0x00; iG = 0xaa; iB = 0xaa;
-			break;
-		case '\\': /*** Lattice (inc. small, left, right). ***/
-			iW = 16; iH = 13;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case ']': /*** Level door right (closed). ***/
-			iW = 12; iH = 12;
-			iR = 0x00; iG = 0xaa; iB = 0xaa;
-			break;
-		case '^': /*** Spikes (out). Harmful. ***/
-			iW = 15; iH = 2;
-			iR = 0xff; iG = 0xff; iB = 0xff;
-			break;
-		case '_': /*** Floor (inc. balcony left/right, stuck button). ***/
-			iW = 16; iH = 6;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '`': /*** Empty with window. ***/
-			iW = 16; iH = 8;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-		case 'g': case 'h': case 'i': case 'j': case 'k': case 'l':
-		case 'm': case 'n': case 'o': case 'p': case 'q': case 'r':
-			/*** Drop buttons a - r (18). ***/
-			iW = 16; iH = 6;
-			iR = 0xff; iG = 0x55; iB = 0x55;
-			break;
-		case 's': case 't': case 'u': case 'v':
-		case 'w': case 'x': case 'y': case 'z':
-			/*** Teleports left s - z (8). ***/
-			iW = 11; iH = 14;
-			iR = 0xaa; iG = 0xaa; iB = 0xaa;
-			break;
-		case '{': /*** Level door left (open). ***/
-			iW = 6; iH = 14;
-			iR = 0x00; iG = 0xaa; iB = 0xaa;
-			break;
-		case '|': /*** Pillar (inc. for lattice). ***/
-			iW = 4; iH = 12;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		case '}': /*** Level door right (open). ***/
-			iW = 9; iH = 12;
-			iR = 0x00; iG = 0xaa; iB = 0xaa;
-			break;
-		case '~': /*** Loose floor (inc. stuck). ***/
-			iW = 16; iH = 6;
-			iR = 0x55; iG = 0x55; iB = 0x55;
-			break;
-		default:
-			printf ("[ WARN ] Unknown tile: %i.\n", cTile);
-			iW = 16; iH = 4; /*** Fallback. ***/
-			iR = 0x00; iG = 0x00; iB = 0x00; /*** Fallback. ***/
-			break;
+		printf ("[ WARN ] Unknown tile: %i.\n", cTile);
+		ShowChar (16, 4, 0x00, 0x00, 0x00, iX, iY, iMode, iZoom, iFade);
+		return;
 	}
-	if (iYellowBack == 1)
+	if ((arTileFlags[iChar] & TILE_TORCH) != 0)
 	{
 		iShowBack = 1 + (int)(12.5 * rand() / (RAND_MAX + 1.0));
 		if (iShowBack == 1)
@@ -2618,7 +3283,9 @@ void ShowTile (char cTile, int iX, int iY, int iFade)
 			ShowChar (12, 14, 0xff, 0xff, 0x55, iX, iY, iMode, iZoom, 0);
 		}
 	}
-	ShowChar (iW, iH, iR, iG, iB, iX, iY, iMode, iZoom, iFade);
+	ShowChar (arTileGlyph[iChar][0], arTileGlyph[iChar][1],
+		arTileColor[iChar][0], arTileColor[iChar][1], arTileColor[iChar][2],
+		iX, iY, iMode, iZoom, iFade);
 }
 /*****************************************************************************/
 void ShowLiving (char cLiving, int iX, int iY)
@@ -2642,7 +3309,7 @@ void ShowLiving (char cLiving, int iX, int iY)
 			ShowChar (16, 1, 0xff, 0xff, 0xff, iX, iY, iMode, iZoom, 0);
 			break;
 		case 'P':
-			if (iCurLives != 0)
+			if (stGame->iCurLives != 0)
 			{
 				ShowChar (2, 1, 0xaa, 0xaa, 0xaa, iX, iY, iMode, iZoom, 0);
 			} else {
@@ -2683,84 +3350,17 @@ void ShowChar (int iW, int iH, int iR, int iG, int iB,
 	}
 }
 /*****************************************************************************/
-int PopUp (char *sQuestion)
+void PopUp (char *sQuestion)
 /*****************************************************************************/
 {
-	int iPopUp;
-	SDL_Event event;
-
-	iPopUp = 2;
-
-	ShowPopUp (sQuestion);
-	while (iPopUp == 2)
-	{
-		while (SDL_PollEvent (&event))
-		{
-			switch (event.type)
-			{
-				case SDL_KEYDOWN:
-					switch (event.key.keysym.sym)
-					{
-						case SDLK_ESCAPE:
-						case SDLK_n:
-							iPopUp = 0;
-							break;
-						case SDLK_KP_ENTER:
-						case SDLK_RETURN:
-						case SDLK_SPACE:
-						case SDLK_y:
-							iPopUp = 1;
-							break;
-					}
-					break;
-				case SDL_MOUSEMOTION:
-					iXPos = event.motion.x;
-					iYPos = event.motion.y;
-					break;
-				case SDL_MOUSEBUTTONDOWN:
-					if (event.button.button == 1)
-					{
-						if (InArea (333, 377, 333 + 85, 377 + 32) == 1) /*** Yes ***/
-						{
-							iOnYes = 1;
-							ShowPopUp (sQuestion);
-						}
-						if (InArea (606, 377, 606 + 85, 377 + 32) == 1) /*** No ***/
-						{
-							iOnNo = 1;
-							ShowPopUp (sQuestion);
-						}
-					}
-					break;
-				case SDL_MOUSEBUTTONUP:
-					iOnYes = 0;
-					iOnNo = 0;
-					if (event.button.button == 1)
-					{
-						if (InArea (333, 377, 333 + 85, 377 + 32) == 1) /*** Yes ***/
-						{
-							iPopUp = 1;
-						}
-						if (InArea (606, 377, 606 + 85, 377 + 32) == 1) /*** No ***/
-						{
-							iPopUp = 0;
-						}
-					}
-					ShowPopUp (sQuestion);
-					break;
-				case SDL_WINDOWEVENT:
-					if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
-						{ ShowGame(); ShowPopUp (sQuestion); } break;
-				case SDL_QUIT:
-					Quit(); break;
-			}
-		}
+	/*** The answer comes from OverlayEvent(). ***/
 
-		PreventCPUEating();
-	}
+	if (iHeadless == 1) { return; }
+	snprintf (sOverlay, MAX_MESSAGE, "%s", sQuestion);
+	iOnYes = 0;
+	iOnNo = 0;
+	iOverlay = OVL_POPUP;
 	ShowGame();
-
-	return (iPopUp);
 }
 /*****************************************************************************/
 void ShowPopUp (char *sQuestion)
@@ -2788,131 +3388,169 @@ void ShowPopUp (char *sQuestion)
 	SDL_RenderPresent (ascreen);
 }
 /*****************************************************************************/
-void DisplayText (int iX, int iY, char *sText)
+void Message (char *sText)
 /*****************************************************************************/
 {
-	text = TTF_RenderText_Shaded (font, sText, color_bl, color_wh);
-	textt = SDL_CreateTextureFromSurface (ascreen, text);
-	offset.x = iX; offset.y = iY;
-	offset.w = text->w; offset.h = text->h;
-	if (SDL_RenderCopy (ascreen, textt, NULL, &offset) != 0)
+	if (iHeadless == 1) { return; }
+	if (iNoWait == 1)
 	{
-		printf ("[ WARN ] SDL_RenderCopy (text): %s.\n", SDL_GetError());
+		printf ("[ INFO ] %s\n", sText);
+		return;
 	}
-	SDL_DestroyTexture (textt); SDL_FreeSurface (text);
+	snprintf (sOverlay, MAX_MESSAGE, "%s", sText);
+	iOverlay = OVL_MESSAGE;
+	ShowGame();
 }
 /*****************************************************************************/
-void TryGoLeft (int iTurns)
+void ShowMessage (void)
 /*****************************************************************************/
 {
-	char cLeft;
-	char cChar;
-
-	/*** Used for looping. ***/
-	int iLoopTurn;
+	DisplayText (350, 260, sOverlay);
+	DisplayText (350, 290, "Press Enter to continue.");
 
-	for (iLoopTurn = 1; iLoopTurn <= iTurns; iLoopTurn++)
-	{
-		/*** Default, nothing changes. ***/
-		iGoRoom = iCurRoom;
-		iGoTile = iPrinceTile;
+	/*** refresh screen ***/
+	SDL_RenderPresent (ascreen);
+}
+/*****************************************************************************/
+int OverlayEvent (SDL_Event *event)
+/*****************************************************************************/
+{
+	/*** Returns 1 if the pop-up was answered with yes. ***/
 
-		cLeft = GetCharLeft (iCurRoom, iPrinceTile);
+	int iYes;
 
-		switch (iTurns)
-		{
-			case 1: /*** walk ***/
-			case 3: /*** jump ***/
-				if ((IsEmpty (cLeft) == 1) || (IsFloor (cLeft) == 1))
-				{
-					iGoRoom = GetRoomLeft (iCurRoom, iPrinceTile);
-					iGoTile = GetTileLeft (iCurRoom, iPrinceTile);
-				} else {
-					PlaySound ("wav/bump.wav");
-					return;
-				}
-				break;
-			case 6: /*** runjump ***/
-				if ((iLoopTurn == 1) || (iLoopTurn == 2))
-				{
-					if (IsFloor (cLeft) == 1)
+	iYes = 0;
+	switch (event->type)
+	{
+		case SDL_KEYDOWN:
+			switch (iOverlay)
+			{
+				case OVL_POPUP:
+					switch (event->key.keysym.sym)
 					{
-						iGoRoom = GetRoomLeft (iCurRoom, iPrinceTile);
-						iGoTile = GetTileLeft (iCurRoom, iPrinceTile);
-					} else { return; }
-				} else {
-					if ((IsEmpty (cLeft) == 1) || (IsFloor (cLeft) == 1) ||
-						(cLeft == '%'))
+						case SDLK_ESCAPE:
+						case SDLK_n:
+							CloseOverlay();
+							break;
+						case SDLK_KP_ENTER:
+						case SDLK_RETURN:
+						case SDLK_SPACE:
+						case SDLK_y:
+							iYes = 1;
+							CloseOverlay();
+							break;
+					}
+					break;
+				case OVL_MESSAGE:
+					switch (event->key.keysym.sym)
 					{
-						iGoRoom = GetRoomLeft (iCurRoom, iPrinceTile);
-						iGoTile = GetTileLeft (iCurRoom, iPrinceTile);
-						if (cLeft == '%')
-						{
-							iCurLives = 1;
-							PlaySound ("wav/mirror.wav");
-							/*** Special events related. ***/
-							if ((iCurLevel == 4) && (iCurRoom == 4) && (iPrinceTile == 6))
-							{
-								arGuardLoc[iCurRoom] = 6;
-								arGuardType[iCurRoom] = 4;
-								arGuardHP[iCurRoom] = iMaxLives;
-								arGuardAttack[iCurRoom] = 0;
-							}
-						}
-					} else {
-						PlaySound ("wav/bump.wav");
-						return;
+						case SDLK_ESCAPE:
+						case SDLK_KP_ENTER:
+						case SDLK_RETURN:
+						case SDLK_SPACE:
+							CloseOverlay();
+							break;
 					}
-				}
-				/*** Special events related. ***/
-				if ((iCurLevel == 6) && (iGoRoom == 1) &&
-					(((iGoTile >= 1) && (iGoTile <= 5)) ||
-					((iGoTile >= 11) && (iGoTile <= 15)) ||
-					((iGoTile >= 21) && (iGoTile <= 25))))
+					break;
+				case OVL_BOSSKEY:
+					if (event->key.keysym.sym == SDLK_F9) { CloseOverlay(); }
+					break;
+				case OVL_SIGN:
+					switch (event->key.keysym.sym)
+					{
+						case SDLK_ESCAPE:
+						case SDLK_KP_ENTER:
+						case SDLK_RETURN:
+						case SDLK_SPACE:
+						case SDLK_q:
+						case SDLK_v:
+							CloseOverlay();
+							break;
+					}
+					break;
+			}
+			break;
+		case SDL_MOUSEMOTION:
+			iXPos = event->motion.x;
+			iYPos = event->motion.y;
+			break;
+		case SDL_MOUSEBUTTONDOWN:
+			if ((iOverlay == OVL_POPUP) && (event->button.button == 1))
+			{
+				if (InArea (333, 377, 333 + 85, 377 + 32) == 1) /*** Yes ***/
+					{ iOnYes = 1; }
+				if (InArea (606, 377, 606 + 85, 377 + 32) == 1) /*** No ***/
+					{ iOnNo = 1; }
+				ShowGame();
+			}
+			break;
+		case SDL_MOUSEBUTTONUP:
+			if (iOverlay == OVL_POPUP)
+			{
+				iOnYes = 0;
+				iOnNo = 0;
+				if (event->button.button == 1)
 				{
-					arGuardLoc[1] = 12;
-					cChar = arTiles[1][12];
-					if (((cChar >= 'A') && (cChar <= 'R')) ||
-						((cChar >= 'a') && (cChar <= 'r')))
+					if (InArea (333, 377, 333 + 85, 377 + 32) == 1) /*** Yes ***/
 					{
-						PushButton (cChar, 1);
-						arTiles[1][12] = '-';
+						iYes = 1;
+						CloseOverlay();
+					} else if (InArea (606, 377, 606 + 85, 377 + 32) == 1) {
+						CloseOverlay(); /*** No ***/
 					}
 				}
-				break;
-		}
-
-		if ((iGoRoom != iCurRoom) || (iGoTile != iPrinceTile))
-		{
-			/*** Special events related. ***/
-			if ((iCurLevel == 12) && (iCurRoom == 13) && (iGoRoom != iCurRoom))
-			{
-				iCurLevel++;
-				LoadLevel (iCurLevel, iMaxLives);
-				return;
-			} else if ((iCurLevel == 14) && (iGoRoom == 5)) {
-				snprintf (sMessage, MAX_MESSAGE, "You used %i steps.\n", iSteps);
-				SDL_ShowSimpleMessageBox (SDL_MESSAGEBOX_INFORMATION,
-					"Victory!", sMessage, window);
-				iSteps = 0;
-				iCurLevel = 1;
-				LoadLevel (iCurLevel, START_LIVES);
-			} else {
-				iCurRoom = iGoRoom;
-				iPrinceTile = iGoTile;
-				if ((iTurns == 6) && ((iLoopTurn == 1) || (iLoopTurn == 2)))
-					{ GameActions(); }
+				ShowGame();
 			}
-		}
+			break;
+		case SDL_WINDOWEVENT:
+			if (event->window.event == SDL_WINDOWEVENT_EXPOSED)
+				{ ShowGame(); } break;
+		case SDL_QUIT:
+			Quit(); break;
 	}
 
-	if ((iTurns == 3) || (iTurns == 6)) { iPrinceHang = 1; }
+	return (iYes);
+}
+/*****************************************************************************/
+void CloseOverlay (void)
+/*****************************************************************************/
+{
+	if (iOverlay == OVL_SIGN)
+	{
+		iMode = iSignMode;
+		iZoom = iSignZoom;
+		if (iSignWarn == 0) { SDL_DestroyTexture (imgsign); }
+	}
+	iOverlay = OVL_NONE;
+	PushHeld();
+	ShowGame();
 }
 /*****************************************************************************/
-void TryGoRight (int iTurns)
+void DisplayText (int iX, int iY, char *sText)
+/*****************************************************************************/
+{
+	text = TTF_RenderText_Shaded (font, sText, color_bl, color_wh);
+	textt = SDL_CreateTextureFromSurface (ascreen, text);
+	offset.x = iX; offset.y = iY;
+	offset.w = text->w; offset.h = text->h;
+	if (SDL_RenderCopy (ascreen, textt, NULL, &offset) != 0)
+	{
+		printf ("[ WARN ] SDL_RenderCopy (text): %s.\n", SDL_GetError());
+	}
+	SDL_DestroyTexture (textt); SDL_FreeSurface (text);
+}
+/*****************************************************************************/
+void TryGoSide (int iDir, int iTurns)
 /*****************************************************************************/
 {
-	char cRight;
+	/*** Walks (1 turn), jumps (3) or run-jumps (6) to TO_LEFT or ***/
+	/*** TO_RIGHT. The first two turns of a run-jump are the run-up: ***/
+	/*** they need a floor, and the game goes on after each of them. ***/
+
+	char cNext;
+	int iRunUp;
+	int iNeed;
+	int iEnds;
 
 	/*** Used for looping. ***/
 	int iLoopTurn;
@@ -2920,55 +3558,72 @@ void TryGoRight (int iTurns)
 	for (iLoopTurn = 1; iLoopTurn <= iTurns; iLoopTurn++)
 	{
 		/*** Default, nothing changes. ***/
-		iGoRoom = iCurRoom;
-		iGoTile = iPrinceTile;
-
-		cRight = GetCharRight (iCurRoom, iPrinceTile);
+		stGame->iGoRoom = stGame->iCurRoom;
+		stGame->iGoTile = stGame->iPrinceTile;
 
-		switch (iTurns)
+		cNext = GetChar (stGame->iCurRoom, stGame->iPrinceTile, iDir);
+		iRunUp = ((iTurns == MOVE_RUNJUMP) && (iLoopTurn <= 2));
+		iNeed = (iRunUp == 1) ? TILE_FLOOR : (TILE_EMPTY | TILE_FLOOR);
+		if ((TileFlags (cNext) & iNeed) == 0)
 		{
-			case 1: /*** walk ***/
-			case 3: /*** jump ***/
-				if ((IsEmpty (cRight) == 1) || (IsFloor (cRight) == 1))
-				{
-					iGoRoom = GetRoomRight (iCurRoom, iPrinceTile);
-					iGoTile = GetTileRight (iCurRoom, iPrinceTile);
-				} else {
-					PlaySound ("wav/bump.wav");
-					return;
-				}
-				break;
-			case 6: /*** runjump ***/
-				if ((iLoopTurn == 1) || (iLoopTurn == 2))
-				{
-					if (IsFloor (cRight) == 1)
-					{
-						iGoRoom = GetRoomRight (iCurRoom, iPrinceTile);
-						iGoTile = GetTileRight (iCurRoom, iPrinceTile);
-					} else { return; }
-				} else {
-					if ((IsEmpty (cRight) == 1) || (IsFloor (cRight) == 1))
-					{
-						iGoRoom = GetRoomRight (iCurRoom, iPrinceTile);
-						iGoTile = GetTileRight (iCurRoom, iPrinceTile);
-					} else {
-						PlaySound ("wav/bump.wav");
-						return;
-					}
-				}
-				break;
+			if ((iTurns != MOVE_RUNJUMP) || (iRunUp == 1) ||
+				(cNext != '%') || (arSideMirror[iDir] == 0))
+			{
+				if (iRunUp == 0) { PlaySound ("wav/bump.wav"); }
+				return;
+			}
+			stGame->iCurLives = 1;
+			PlaySound ("wav/mirror.wav");
 		}
+		stGame->iGoRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, iDir);
+		stGame->iGoTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, iDir);
 
-		if ((iGoRoom != iCurRoom) || (iGoTile != iPrinceTile))
+		if ((stGame->iGoRoom != stGame->iCurRoom) ||
+			(stGame->iGoTile != stGame->iPrinceTile))
 		{
-			iCurRoom = iGoRoom;
-			iPrinceTile = iGoTile;
-			if ((iTurns == 6) && ((iLoopTurn == 1) || (iLoopTurn == 2)))
-				{ GameActions(); }
+			stGame->iGoSide = 1;
+			iEnds = RunTriggers (TRIG_ENTER, stGame->iGoRoom, stGame->iGoTile);
+			stGame->iGoSide = 0;
+			if (iEnds == 1) { return; }
+			stGame->iCurRoom = stGame->iGoRoom;
+			stGame->iPrinceTile = stGame->iGoTile;
+			if (iRunUp == 1)
+			{
+				GameActions();
+				if (stGame->iSequence != SEQ_NONE) { return; }
+			}
 		}
 	}
 
-	if ((iTurns == 3) || (iTurns == 6)) { iPrinceHang = 1; }
+	if (iTurns != MOVE_WALK) { stGame->iPrinceHang = 1; }
+}
+/*****************************************************************************/
+void TryCareful (int iDir)
+/*****************************************************************************/
+{
+	/*** A careful step to TO_LEFT or TO_RIGHT: it drops a loose floor ***/
+	/*** in front, hangs down an edge or steps on spikes unhurt. ***/
+
+	switch (GetChar (stGame->iCurRoom, stGame->iPrinceTile, iDir))
+	{
+		case '~':
+			DropLoose (GetRoom (stGame->iCurRoom, stGame->iPrinceTile, iDir),
+				GetTile (stGame->iCurRoom, stGame->iPrinceTile, iDir));
+			break;
+		case '.':
+			if ((stGame->arTile[PrinceCell()] != '<') &&
+				(stGame->arTile[PrinceCell()] != '>'))
+			{
+				stGame->iPrinceHang = 1;
+				stGame->iPrinceSafe = 1; /*** In case of spikes below. ***/
+				TryGoSide (iDir, MOVE_WALK);
+			}
+			break;
+		case '^':
+			stGame->iPrinceSafe = 1;
+			TryGoSide (iDir, MOVE_WALK);
+			break;
+	}
 }
 /*****************************************************************************/
 void TryGoUp (void)
@@ -2979,17 +3634,17 @@ void TryGoUp (void)
 	char cGoTo;
 
 	/*** Default, nothing changes. ***/
-	iGoRoom = iCurRoom;
-	iGoTile = iPrinceTile;
+	stGame->iGoRoom = stGame->iCurRoom;
+	stGame->iGoTile = stGame->iPrinceTile;
 
-	cLeft = GetCharLeft (iCurRoom, iPrinceTile);
-	cRight = GetCharRight (iCurRoom, iPrinceTile);
-	cUp = GetCharUp (iCurRoom, iPrinceTile);
-	cUpRight = GetCharUpRight (iCurRoom, iPrinceTile);
-	cUpLeft = GetCharUpLeft (iCurRoom, iPrinceTile);
+	cLeft = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+	cRight = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
+	cUp = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_UP);
+	cUpRight = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_UPRIGHT);
+	cUpLeft = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_UPLEFT);
 
 	/*** Custom Puny Prince tile. ***/
-	if (arTiles[iCurRoom][iPrinceTile] == '&')
+	if (stGame->arTile[PrinceCell()] == '&')
 	{
 		/* CUSTOM INFO
 		 * Add code below if something should happen when the player presses
@@ -2999,84 +3654,90 @@ void TryGoUp (void)
 	}
 
 	/*** Level door left/right (open). ***/
-	if ((arTiles[iCurRoom][iPrinceTile] == '{') ||
-		(arTiles[iCurRoom][iPrinceTile] == '}'))
+	if ((stGame->arTile[PrinceCell()] == '{') ||
+		(stGame->arTile[PrinceCell()] == '}'))
 	{
-		iCurLevel++;
-		LoadLevel (iCurLevel, iMaxLives);
+		StartSequence (SEQ_LEVEL, LEVEL_TICKS);
 		return;
 	}
 
 	/*** Teleports left/right. ***/
-	if (((arTiles[iCurRoom][iPrinceTile] >= 'S') &&
-		(arTiles[iCurRoom][iPrinceTile] <= 'Z')) ||
-		((arTiles[iCurRoom][iPrinceTile] >= 's') &&
-		(arTiles[iCurRoom][iPrinceTile] <= 's')) ||
-		(arTiles[iCurRoom][iPrinceTile] == ','))
-	{
-		if (arTiles[iCurRoom][iPrinceTile] == ',')
-			{ cGoTo = GetCharLeft (iCurRoom, iPrinceTile); }
-				else { cGoTo = arTiles[iCurRoom][iPrinceTile]; }
+	if ((TileFlags (stGame->arTile[PrinceCell()]) &
+		TILE_TELEPORT) != 0)
+	{
+		if (stGame->arTile[PrinceCell()] == ',')
+			{ cGoTo = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT); }
+				else { cGoTo = stGame->arTile[PrinceCell()]; }
 		Teleport (cGoTo);
 		return;
 	}
 
 	if (IsEmpty (cUp) == 1)
 	{
-		if ((iPrinceDir == 1) && (IsFloor (cUpLeft) == 1))
+		if ((stGame->iPrinceDir == 1) && (IsFloor (cUpLeft) == 1))
 		{
-			iGoRoom = GetRoomUpLeft (iCurRoom, iPrinceTile);
-			iGoTile = GetTileUpLeft (iCurRoom, iPrinceTile);
+			stGame->iGoRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_UPLEFT);
+			stGame->iGoTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_UPLEFT);
 		}
-		if ((iPrinceDir == 2) && (IsFloor (cUpRight) == 1))
+		if ((stGame->iPrinceDir == 2) && (IsFloor (cUpRight) == 1))
 		{
-			iGoRoom = GetRoomUpRight (iCurRoom, iPrinceTile);
-			iGoTile = GetTileUpRight (iCurRoom, iPrinceTile);
+			stGame->iGoRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_UPRIGHT);
+			stGame->iGoTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_UPRIGHT);
 		}
 	}
 	if (IsFloor (cUp) == 1)
 	{
 		if (((IsEmpty (cUpLeft) == 1) &&
-			((IsEmpty (cLeft) == 1) || (IsFloor (cLeft) == 1))) ||
+			((TileFlags (cLeft) & (TILE_EMPTY | TILE_FLOOR)) != 0)) ||
 			((IsEmpty (cUpRight) == 1) &&
-			((IsEmpty (cRight) == 1) || (IsFloor (cRight) == 1))))
+			((TileFlags (cRight) & (TILE_EMPTY | TILE_FLOOR)) != 0)))
 		{
-			iGoRoom = GetRoomUp (iCurRoom, iPrinceTile);
-			iGoTile = GetTileUp (iCurRoom, iPrinceTile);
+			stGame->iGoRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_UP);
+			stGame->iGoTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_UP);
 		}
 	}
 
 	/*** Loose floors. ***/
 	if (cUp == '~')
 	{
-		if (iPrinceTile > 10)
+		if (stGame->iPrinceTile > 10)
 		{
-			DropLoose (iCurRoom, iPrinceTile - 10);
-		} else if (arLinksU[iCurRoom] != 0) {
-			DropLoose (arLinksU[iCurRoom], iPrinceTile + 20);
+			DropLoose (stGame->iCurRoom, stGame->iPrinceTile - 10);
+		} else if (stGame->arLinksU[stGame->iCurRoom] != 0) {
+			DropLoose (stGame->arLinksU[stGame->iCurRoom],
+				stGame->iPrinceTile + 20);
 		}
-	} else if ((iPrinceDir == 1) && (cUpLeft == '~')) {
-		iRoom = GetRoomUpLeft (iCurRoom, iPrinceTile);
-		iTile = GetTileUpLeft (iCurRoom, iPrinceTile);
+	} else if ((stGame->iPrinceDir == 1) && (cUpLeft == '~')) {
+		iRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_UPLEFT);
+		iTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_UPLEFT);
 		DropLoose (iRoom, iTile);
-	} else if ((iPrinceDir == 2) && (cUpRight == '~')) {
-		iRoom = GetRoomUpRight (iCurRoom, iPrinceTile);
-		iTile = GetTileUpRight (iCurRoom, iPrinceTile);
+	} else if ((stGame->iPrinceDir == 2) && (cUpRight == '~')) {
+		iRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_UPRIGHT);
+		iTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_UPRIGHT);
 		DropLoose (iRoom, iTile);
 	} else if (cUpLeft == '~') {
-		iRoom = GetRoomUpLeft (iCurRoom, iPrinceTile);
-		iTile = GetTileUpLeft (iCurRoom, iPrinceTile);
+		iRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_UPLEFT);
+		iTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_UPLEFT);
 		DropLoose (iRoom, iTile);
 	} else if (cUpRight == '~') {
-		iRoom = GetRoomUpRight (iCurRoom, iPrinceTile);
-		iTile = GetTileUpRight (iCurRoom, iPrinceTile);
+		iRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_UPRIGHT);
+		iTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_UPRIGHT);
 		DropLoose (iRoom, iTile);
 	}
 
-	if ((iGoRoom != iCurRoom) || (iGoTile != iPrinceTile))
+	if ((stGame->iGoRoom != stGame->iCurRoom) ||
+		(stGame->iGoTile != stGame->iPrinceTile))
 	{
-		iCurRoom = iGoRoom;
-		iPrinceTile = iGoTile;
+		if (RunTriggers (TRIG_ENTER, stGame->iGoRoom,
+			stGame->iGoTile) == 1) { return; }
+		stGame->iCurRoom = stGame->iGoRoom;
+		stGame->iPrinceTile = stGame->iGoTile;
 	}
 }
 /*****************************************************************************/
@@ -3084,649 +3745,689 @@ void TryGoDown (void)
 /*****************************************************************************/
 {
 	char cLeft, cRight, cDown;
-	char cTile;
 
 	/*** Default, nothing changes. ***/
-	iGoRoom = iCurRoom;
-	iGoTile = iPrinceTile;
-
-	cLeft = GetCharLeft (iCurRoom, iPrinceTile);
-	cRight = GetCharRight (iCurRoom, iPrinceTile);
-	cDown = GetCharDown (iCurRoom, iPrinceTile);
-
-	switch (arTiles[iCurRoom][iPrinceTile])
-	{
-		case '!': /*** Sword. ***/
-			iPrinceSword = 1;
-			iFlash = 10;
-			iFlashR = 0xff; iFlashG = 0xff; iFlashB = 0x55;
-			arTiles[iCurRoom][iPrinceTile] = '_';
-			/*** Special events related. ***/
-			if ((iCurLevel == 12) && (iCurRoom == 15) && (iPrinceTile == 2))
+	stGame->iGoRoom = stGame->iCurRoom;
+	stGame->iGoTile = stGame->iPrinceTile;
+
+	cLeft = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+	cRight = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
+	cDown = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_DOWN);
+
+	TileAction (arTileDown[(unsigned char)stGame->arTile[PrinceCell()]],
+		PrinceCell());
+
+	if ((TileFlags (cDown) & (TILE_EMPTY | TILE_FLOOR)) != 0)
+	{
+		if (((TileFlags (cLeft) | TileFlags (cRight)) & TILE_EMPTY) != 0)
+		{
+			stGame->iGoRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_DOWN);
+			stGame->iGoTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile,
+				TO_DOWN);
+		}
+	}
+
+	if ((stGame->iGoRoom != stGame->iCurRoom) ||
+		(stGame->iGoTile != stGame->iPrinceTile))
+	{
+		if (RunTriggers (TRIG_ENTER, stGame->iGoRoom,
+			stGame->iGoTile) == 1) { return; }
+		stGame->iCurRoom = stGame->iGoRoom;
+		stGame->iPrinceTile = stGame->iGoTile;
+	}
+}
+/*****************************************************************************/
+void TakeSword (int iCell)
+/*****************************************************************************/
+{
+	stGame->iPrinceSword = 1;
+	Flash (0xff, 0xff, 0x55);
+	SetTile (iCell, '_');
+	RunTriggers (TRIG_SWORD, iCell / ROOM_CELLS, arCellTile[iCell % ROOM_CELLS]);
+}
+/*****************************************************************************/
+void TileAction (int iAction, int iCell)
+/*****************************************************************************/
+{
+	/*** Does what arTileStep or arTileDown says, for the prince on iCell. ***/
+
+	char cTile;
+	int iRoom, iTile;
+
+	cTile = stGame->arTile[iCell];
+	iRoom = iCell / ROOM_CELLS;
+	iTile = arCellTile[iCell % ROOM_CELLS];
+	switch (iAction)
+	{
+		case ACT_SPIKES:
+			if (stGame->iPrinceSafe == 0)
 			{
-				arTiles[2][1] = '9';
-				arTiles[2][2] = '9';
-				arTiles[2][3] = '9';
-				arTiles[2][4] = '9';
-				arTiles[2][5] = '9';
-				arTiles[2][6] = '9';
-				arTiles[2][7] = '9';
-				arTiles[2][8] = '9';
-				arTiles[13][7] = '9';
-				arTiles[13][8] = '9';
-				arTiles[13][9] = '9';
-				arTiles[13][10] = '9';
+				PlaySound ("wav/spikes_death_b.wav");
+				stGame->iCurLives = 0;
+				Flash (0xaa, 0x00, 0x00);
 			}
 			break;
-		case '0': /*** Potion (empty). ***/
-			arTiles[iCurRoom][iPrinceTile] = '_';
+		case ACT_LOOSE:
+			DropLoose (iRoom, iTile);
+			break;
+		case ACT_BUTTON:
+			PushButton (cTile, 0);
+			break;
+		case ACT_CHOMPER:
+			PlaySound ("wav/chomper_death.wav");
+			stGame->iCurLives = 0;
+			Flash (0xaa, 0x00, 0x00);
+			break;
+		case ACT_COIN:
+			SetTile (iCell, '_');
+			stGame->iPrinceCoins++;
+			PlaySound ("wav/coin.wav");
+			stGame->iShowStepsCoins = 1;
+			Flash (0xff, 0xff, 0x55);
+			break;
+		case ACT_REVEAL:
+			SetTile (iCell, '_');
+			break;
+		case ACT_SWORD:
+			TakeSword (iCell);
+			break;
+		case ACT_EMPTY:
+			SetTile (iCell, '_');
 			break;
-		case '1': /*** Potion (heal). ***/
+		case ACT_HEAL:
 			PlaySound ("wav/drinking.wav");
-			if (iCurLives < iMaxLives)
+			if (stGame->iCurLives < stGame->iMaxLives)
 			{
-				iCurLives++;
-				iFlash = 10;
-				iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
+				stGame->iCurLives++;
+				Flash (0xaa, 0x00, 0x00);
 			}
-			arTiles[iCurRoom][iPrinceTile] = '_';
+			SetTile (iCell, '_');
 			break;
-		case '2': /*** Potion (life). ***/
+		case ACT_LIFE:
 			PlaySound ("wav/drinking.wav");
-			iMaxLives++;
-			iCurLives = iMaxLives;
-			iLevLives++;
-			iFlash = 10;
-			iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
-			arTiles[iCurRoom][iPrinceTile] = '_';
+			stGame->iMaxLives++;
+			stGame->iCurLives = stGame->iMaxLives;
+			stGame->iLevLives++;
+			Flash (0xaa, 0x00, 0x00);
+			SetTile (iCell, '_');
 			break;
-		case '3': /*** Potion (float). ***/
+		case ACT_FLOAT:
 			PlaySound ("wav/drinking.wav");
-			iPrinceFloat+=50;
-			iFlash = 10;
-			iFlashR = 0x00; iFlashG = 0xaa; iFlashB = 0x00;
-			arTiles[iCurRoom][iPrinceTile] = '_';
+			stGame->iPrinceFloat+=50;
+			Flash (0x00, 0xaa, 0x00);
+			SetTile (iCell, '_');
 			break;
-		case '4': /*** Potion (flip). ***/
-			/*** Not yet implemented. ***/
-			break;
-		case '5': /*** Potion (hurt). ***/
+		case ACT_HURT:
 			PlaySound ("wav/drinking.wav");
-			SDL_Delay (500);
-			PlaySound ("wav/hit_prince.wav");
-			iCurLives--;
-			if (iCurLives == 0) { Die(); return; }
-			iFlash = 10;
-			iFlashR = 0x00; iFlashG = 0x00; iFlashB = 0xaa;
-			arTiles[iCurRoom][iPrinceTile] = '_';
+			stGame->iSequenceCell = iCell;
+			StartSequence (SEQ_HURT, HURT_TICKS); /*** Hurts when it ends. ***/
 			break;
-		case '6': /*** Potion (special blue). ***/
+		case ACT_BLUE:
 			PlaySound ("wav/drinking.wav");
-			cTile = arTiles[8][1];
-			switch (cTile)
+			cTile = stGame->arTile[Cell (8, 1)];
+			if ((TileFlags (cTile) & TILE_BUTTON) != 0)
 			{
-				case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-				case 'G': case 'H': case 'I': case 'J': case 'K': case 'L':
-				case 'M': case 'N': case 'O': case 'P': case 'Q': case 'R':
-					/*** Raise buttons A - R (18). ***/
-					PushButton (cTile, 0);
-					break;
-				case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-				case 'g': case 'h': case 'i': case 'j': case 'k': case 'l':
-				case 'm': case 'n': case 'o': case 'p': case 'q': case 'r':
-					/*** Drop buttons a - r (18). ***/
-					PushButton (cTile, 0);
-					break;
-				case '*': arTiles[8][1] = '^'; break;
-				case ')': arTiles[8][1] = '"'; break;
-				case '~': DropLoose (8, 1); break;
+				PushButton (cTile, 0);
+			} else {
+				switch (cTile)
+				{
+					case '*': SetTile (Cell (8, 1), '^'); break;
+					case ')': SetTile (Cell (8, 1), '"'); break;
+					case '~': DropLoose (8, 1); break;
+				}
 			}
 			break;
-		case '&': /*** Custom Puny Prince tile. ***/
-			/* CUSTOM INFO
-			 * Add code below if something should happen when the player presses
-			 * Arrow Down while on a custom tile.
-			 */
-			break;
-	}
-
-	if ((IsEmpty (cDown) == 1) || (IsFloor (cDown) == 1))
-	{
-		if ((IsEmpty (cLeft) == 1) || (IsEmpty (cRight) == 1))
-		{
-			iGoRoom = GetRoomDown (iCurRoom, iPrinceTile);
-			iGoTile = GetTileDown (iCurRoom, iPrinceTile);
-		}
-	}
-
-	if ((iGoRoom != iCurRoom) || (iGoTile != iPrinceTile))
-	{
-		iCurRoom = iGoRoom;
-		iPrinceTile = iGoTile;
 	}
 }
 /*****************************************************************************/
 void ToggleJump (void)
 /*****************************************************************************/
 {
-	if (iJump == 0)
+	if (stGame->iJump == 0)
 	{
-		iJump = 1;
-		iCareful = 0;
-		iRunJump = 0;
+		stGame->iJump = 1;
+		stGame->iCareful = 0;
+		stGame->iRunJump = 0;
 	} else {
-		iJump = 0;
+		stGame->iJump = 0;
 	}
 }
 /*****************************************************************************/
 void ToggleCareful (void)
 /*****************************************************************************/
 {
-	if (iCareful == 0)
+	if (stGame->iCareful == 0)
 	{
-		iCareful = 1;
-		iJump = 0;
-		iRunJump = 0;
+		stGame->iCareful = 1;
+		stGame->iJump = 0;
+		stGame->iRunJump = 0;
 	} else {
-		iCareful = 0;
+		stGame->iCareful = 0;
 	}
 }
 /*****************************************************************************/
 void ToggleRunJump (void)
 /*****************************************************************************/
 {
-	if (iRunJump == 0)
+	if (stGame->iRunJump == 0)
 	{
-		iRunJump = 1;
-		iJump = 0;
-		iCareful = 0;
+		stGame->iRunJump = 1;
+		stGame->iJump = 0;
+		stGame->iCareful = 0;
 	} else {
-		iRunJump = 0;
+		stGame->iRunJump = 0;
 	}
 }
 /*****************************************************************************/
-char GetCharLeft (int iRoom, int iTile)
+int NeighbourCell (int iRoom, int iTile, int iDir)
 /*****************************************************************************/
 {
-	if ((iTile != 1) && (iTile != 11) && (iTile != 21))
+	/*** Returns the cell, or 0 if there is no room. ***/
+
+	int iNRoom, iNTile;
+
+	iNRoom = 0;
+	iNTile = 0;
+	switch (iDir)
 	{
-		return (arTiles[iRoom][iTile - 1]);
-	} else if (arLinksL[iRoom] != 0) {
-		return (arTiles[arLinksL[iRoom]][iTile + 9]);
-	} else {
-		return ('#');
+		case TO_LEFT:
+			if ((iTile != 1) && (iTile != 11) && (iTile != 21))
+			{
+				iNRoom = iRoom; iNTile = iTile - 1;
+			} else if (stGame->arLinksL[iRoom] != 0) {
+				iNRoom = stGame->arLinksL[iRoom]; iNTile = iTile + 9;
+			}
+			break;
+		case TO_RIGHT:
+			if ((iTile != 10) && (iTile != 20) && (iTile != 30))
+			{
+				iNRoom = iRoom; iNTile = iTile + 1;
+			} else if (stGame->arLinksR[iRoom] != 0) {
+				iNRoom = stGame->arLinksR[iRoom]; iNTile = iTile - 9;
+			}
+			break;
+		case TO_UP:
+			if (iTile > 10)
+			{
+				iNRoom = iRoom; iNTile = iTile - 10;
+			} else if (stGame->arLinksU[iRoom] != 0) {
+				iNRoom = stGame->arLinksU[iRoom]; iNTile = iTile + 20;
+			}
+			break;
+		case TO_DOWN:
+			if (iTile <= 20)
+			{
+				iNRoom = iRoom; iNTile = iTile + 10;
+			} else if (stGame->arLinksD[iRoom] != 0) {
+				iNRoom = stGame->arLinksD[iRoom]; iNTile = iTile - 20;
+			}
+			break;
+		case TO_UPLEFT:
+			if (((iTile >= 12) && (iTile <= 20)) ||
+				((iTile >= 22) && (iTile <= 30)))
+			{
+				iNRoom = iRoom; iNTile = iTile - 11;
+			} else if ((iTile == 11) || (iTile == 21)) {
+				if (stGame->arLinksL[iRoom] != 0)
+					{ iNRoom = stGame->arLinksL[iRoom]; iNTile = iTile - 1; }
+			} else if ((iTile >= 2) && (iTile <= 10)) {
+				if (stGame->arLinksU[iRoom] != 0)
+					{ iNRoom = stGame->arLinksU[iRoom]; iNTile = iTile + 19; }
+			} else { /*** iTile == 1 ***/
+				if ((stGame->arLinksL[iRoom] != 0) &&
+					(stGame->arLinksU[stGame->arLinksL[iRoom]] != 0))
+					{ iNRoom = stGame->arLinksU[stGame->arLinksL[iRoom]]; iNTile = 30; }
+			}
+			break;
+		case TO_UPRIGHT:
+			if (((iTile >= 11) && (iTile <= 19)) ||
+				((iTile >= 21) && (iTile <= 29)))
+			{
+				iNRoom = iRoom; iNTile = iTile - 9;
+			} else if ((iTile == 20) || (iTile == 30)) {
+				if (stGame->arLinksR[iRoom] != 0)
+					{ iNRoom = stGame->arLinksR[iRoom]; iNTile = iTile - 19; }
+			} else if ((iTile >= 1) && (iTile <= 9)) {
+				if (stGame->arLinksU[iRoom] != 0)
+					{ iNRoom = stGame->arLinksU[iRoom]; iNTile = iTile + 21; }
+			} else { /*** iTile == 10 ***/
+				if ((stGame->arLinksR[iRoom] != 0) &&
+					(stGame->arLinksU[stGame->arLinksR[iRoom]] != 0))
+					{ iNRoom = stGame->arLinksU[stGame->arLinksR[iRoom]]; iNTile = 21; }
+			}
+			break;
 	}
+
+	if (iNRoom == 0) { return (0); }
+	return (Cell (iNRoom, iNTile));
 }
 /*****************************************************************************/
-char GetCharRight (int iRoom, int iTile)
+void BuildNeighbours (void)
 /*****************************************************************************/
 {
-	if ((iTile != 10) && (iTile != 20) && (iTile != 30))
+	/*** Fills the ghost cells, and chains them to the tiles they copy. ***/
+
+	int iCell, iGhost, iReal;
+
+	/*** Used for looping. ***/
+	int iLoopRoom;
+	int iLoopTile;
+	int iLoopDir;
+
+	memset (stGame->arReal, 0, sizeof (stGame->arReal));
+	memset (stGame->arGhostNext, 0, sizeof (stGame->arGhostNext));
+	memset (stGame->arTile, '#', ROOM_CELLS); /*** Room 0, outside. ***/
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
 	{
-		return (arTiles[iRoom][iTile + 1]);
-	} else if (arLinksR[iRoom] != 0) {
-		return (arTiles[arLinksR[iRoom]][iTile - 9]);
-	} else {
-		return ('#');
+		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+		{
+			iCell = Cell (iLoopRoom, iLoopTile);
+			stGame->arReal[iCell] = iCell;
+		}
+	}
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	{
+		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+		{
+			for (iLoopDir = 1; iLoopDir <= DIRS; iLoopDir++)
+			{
+				iGhost = Cell (iLoopRoom, iLoopTile) + arDirOffset[iLoopDir];
+				if ((arCellTile[iGhost % ROOM_CELLS] != 0) ||
+					(stGame->arReal[iGhost] != 0)) { continue; }
+				iReal = NeighbourCell (iLoopRoom, iLoopTile, iLoopDir);
+				stGame->arReal[iGhost] = iReal;
+				stGame->arTile[iGhost] = stGame->arTile[iReal];
+				if (iReal != 0)
+				{
+					stGame->arGhostNext[iGhost] = stGame->arGhostNext[iReal];
+					stGame->arGhostNext[iReal] = iGhost;
+				}
+			}
+		}
 	}
 }
 /*****************************************************************************/
-char GetCharUp (int iRoom, int iTile)
+void InitCells (void)
 /*****************************************************************************/
 {
-	if (iTile > 10)
+	/*** Used for looping. ***/
+	int iLoopTile;
+
+	/*** Tile 0 is a ghost mid-left, so that room 0 has cells all around. ***/
+	arTileCell[0] = 2 * ROOM_W;
+	memset (arCellTile, 0, sizeof (arCellTile));
+	for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
 	{
-		return (arTiles[iRoom][iTile - 10]);
-	} else if (arLinksU[iRoom] != 0) {
-		return (arTiles[arLinksU[iRoom]][iTile + 20]);
-	} else {
-		return ('#');
+		arTileCell[iLoopTile] = ((((iLoopTile - 1) / 10) + 1) * ROOM_W) +
+			((iLoopTile - 1) % 10) + 1;
+		arCellTile[arTileCell[iLoopTile]] = iLoopTile;
 	}
 }
 /*****************************************************************************/
-char GetCharDown (int iRoom, int iTile)
+int Cell (int iRoom, int iTile)
 /*****************************************************************************/
 {
-	if (iTile <= 20)
-	{
-		return (arTiles[iRoom][iTile + 10]);
-	} else if (arLinksD[iRoom] != 0) {
-		return (arTiles[arLinksD[iRoom]][iTile - 20]);
-	} else {
-		return ('#');
-	}
+	return ((iRoom * ROOM_CELLS) + arTileCell[iTile]);
 }
 /*****************************************************************************/
-char GetCharUpLeft (int iRoom, int iTile)
+int PrinceCell (void)
 /*****************************************************************************/
 {
-	if (((iTile >= 12) && (iTile <= 20)) ||
-		((iTile >= 22) && (iTile <= 30)))
-	{
-		return (arTiles[iRoom][iTile - 11]);
-	} else if ((iTile == 11) || (iTile == 21)) {
-		if (arLinksL[iRoom] != 0)
-		{
-			return (arTiles[arLinksL[iRoom]][iTile - 1]);
-		} else {
-			return ('#');
-		}
-	} else if ((iTile >= 2) && (iTile <= 10)) {
-		if (arLinksU[iRoom] != 0)
-		{
-			return (arTiles[arLinksU[iRoom]][iTile + 19]);
-		} else {
-			return ('#');
-		}
-	} else { /*** iTile == 1 ***/
-		if (arLinksL[iRoom] != 0)
-		{
-			if (arLinksU[arLinksL[iRoom]] != 0)
-			{
-				return (arTiles[arLinksU[arLinksL[iRoom]]][30]);
-			} else {
-				return ('#');
-			}
-		} else {
-			return ('#');
-		}
-	}
+	return (Cell (stGame->iCurRoom, stGame->iPrinceTile));
 }
 /*****************************************************************************/
-char GetCharUpRight (int iRoom, int iTile)
+void SetTile (int iCell, char cChar)
 /*****************************************************************************/
 {
-	if (((iTile >= 11) && (iTile <= 19)) ||
-		((iTile >= 21) && (iTile <= 29)))
+	/*** Changes a tile, its bitboards, and its copies in the ghost cells ***/
+	/*** of other rooms. ***/
+
+	int iRoom;
+	Uint32 iBit;
+	int iFlags;
+
+	/*** Used for looping. ***/
+	int iLoopBoard;
+
+	stGame->iHash ^= ZobristTile (iCell, stGame->arTile[iCell]) ^
+		ZobristTile (iCell, cChar);
+
+	iRoom = iCell / ROOM_CELLS;
+	iBit = (Uint32)1 << (arCellTile[iCell % ROOM_CELLS] - 1);
+	iFlags = TileFlags (cChar);
+	for (iLoopBoard = 0; iLoopBoard < BOARDS; iLoopBoard++)
 	{
-		return (arTiles[iRoom][iTile - 9]);
-	} else if ((iTile == 20) || (iTile == 30)) {
-		if (arLinksR[iRoom] != 0)
-		{
-			return (arTiles[arLinksR[iRoom]][iTile - 19]);
-		} else {
-			return ('#');
-		}
-	} else if ((iTile >= 1) && (iTile <= 9)) {
-		if (arLinksU[iRoom] != 0)
-		{
-			return (arTiles[arLinksU[iRoom]][iTile + 21]);
-		} else {
-			return ('#');
-		}
-	} else { /*** iTile == 10 ***/
-		if (arLinksR[iRoom] != 0)
+		if ((iFlags & arBoardFlag[iLoopBoard]) != 0)
 		{
-			if (arLinksU[arLinksR[iRoom]] != 0)
-			{
-				return (arTiles[arLinksU[arLinksR[iRoom]]][21]);
-			} else {
-				return ('#');
-			}
+			stGame->arBoard[iRoom][iLoopBoard] |= iBit;
 		} else {
-			return ('#');
+			stGame->arBoard[iRoom][iLoopBoard] &= ~iBit;
 		}
 	}
+
+	do {
+		stGame->arTile[iCell] = cChar;
+		iCell = stGame->arGhostNext[iCell];
+	} while (iCell != 0);
 }
 /*****************************************************************************/
-int GetRoomLeft (int iRoom, int iTile)
+char GetChar (int iRoom, int iTile, int iDir)
 /*****************************************************************************/
 {
-	if ((iTile != 1) && (iTile != 11) && (iTile != 21))
-	{
-		return (iRoom);
-	} else if (arLinksL[iRoom] != 0) {
-		return (arLinksL[iRoom]);
-	} else {
-		return (0);
-	}
+	return (stGame->arTile[Cell (iRoom, iTile) + arDirOffset[iDir]]);
 }
 /*****************************************************************************/
-int GetRoomRight (int iRoom, int iTile)
+int GetRoom (int iRoom, int iTile, int iDir)
 /*****************************************************************************/
 {
-	if ((iTile != 10) && (iTile != 20) && (iTile != 30))
-	{
-		return (iRoom);
-	} else if (arLinksR[iRoom] != 0) {
-		return (arLinksR[iRoom]);
-	} else {
-		return (0);
-	}
+	return (stGame->arReal[Cell (iRoom, iTile) + arDirOffset[iDir]] / ROOM_CELLS);
 }
 /*****************************************************************************/
-int GetRoomUp (int iRoom, int iTile)
+int GetTile (int iRoom, int iTile, int iDir)
 /*****************************************************************************/
 {
-	if (iTile > 10)
-	{
-		return (iRoom);
-	} else if (arLinksU[iRoom] != 0) {
-		return (arLinksU[iRoom]);
-	} else {
-		return (0);
-	}
+	return (arCellTile[stGame->arReal[Cell (iRoom, iTile) + arDirOffset[iDir]] %
+		ROOM_CELLS]);
 }
 /*****************************************************************************/
-int GetRoomDown (int iRoom, int iTile)
+void BuildTiles (void)
 /*****************************************************************************/
 {
-	if (iTile <= 20)
-	{
-		return (iRoom);
-	} else if (arLinksD[iRoom] != 0) {
-		return (arLinksD[iRoom]);
-	} else {
-		return (0);
-	}
-}
-/*****************************************************************************/
-int GetRoomUpLeft (int iRoom, int iTile)
-/*****************************************************************************/
-{
-	if (((iTile >= 12) && (iTile <= 20)) ||
-		((iTile >= 22) && (iTile <= 30)))
+	int iDef;
+
+	/*** Used for looping. ***/
+	int iLoopChar;
+	int iLoopVariant;
+
+	for (iLoopChar = 0; iLoopChar <= 255; iLoopChar++)
+		{ SetTileDef (iLoopChar, TILE_FLOOR, 0, 0, 0, ACT_NONE, ACT_NONE); }
+	for (iDef = 0; iDef < (int)(sizeof (arTileDefs) /
+		sizeof (arTileDefs[0])); iDef++)
 	{
-		return (iRoom);
-	} else if ((iTile == 11) || (iTile == 21)) {
-		if (arLinksL[iRoom] != 0)
-		{
-			return (arLinksL[iRoom]);
-		} else {
-			return (0);
-		}
-	} else if ((iTile >= 2) && (iTile <= 10)) {
-		if (arLinksU[iRoom] != 0)
+		for (iLoopChar = (unsigned char)arTileDefs[iDef].cFirst;
+			iLoopChar <= (unsigned char)arTileDefs[iDef].cLast; iLoopChar++)
 		{
-			return (arLinksU[iRoom]);
-		} else {
-			return (0);
+			SetTileDef (iLoopChar, arTileDefs[iDef].iFlags,
+				arTileDefs[iDef].iW, arTileDefs[iDef].iH, arTileDefs[iDef].iColor,
+				arTileDefs[iDef].iStep, arTileDefs[iDef].iDown);
 		}
-	} else { /*** iTile == 1 ***/
-		if (arLinksL[iRoom] != 0)
+	}
+
+	memset (arDatTile, 0, sizeof (arDatTile));
+	for (iDef = 0; iDef < (int)(sizeof (arDatDefs) /
+		sizeof (arDatDefs[0])); iDef++)
+	{
+		for (iLoopVariant = arDatDefs[iDef].iFirst;
+			iLoopVariant <= arDatDefs[iDef].iLast; iLoopVariant++)
 		{
-			if (arLinksU[arLinksL[iRoom]] != 0)
+			arDatTile[arDatDefs[iDef].iGroup][iLoopVariant] =
+				arDatDefs[iDef].cFirst;
+			if (arDatDefs[iDef].cFirst != arDatDefs[iDef].cLast)
 			{
-				return (arLinksU[arLinksL[iRoom]]);
-			} else {
-				return (0);
+				arDatTile[arDatDefs[iDef].iGroup][iLoopVariant] +=
+					iLoopVariant - arDatDefs[iDef].iFirst;
 			}
-		} else {
-			return (0);
 		}
 	}
 }
 /*****************************************************************************/
-int GetRoomUpRight (int iRoom, int iTile)
+void SetTileDef (int iChar, int iFlags, int iW, int iH, int iColor,
+	int iStep, int iDown)
 /*****************************************************************************/
 {
-	if (((iTile >= 11) && (iTile <= 19)) ||
-		((iTile >= 21) && (iTile <= 29)))
-	{
-		return (iRoom);
-	} else if ((iTile == 20) || (iTile == 30)) {
-		if (arLinksR[iRoom] != 0)
-		{
-			return (arLinksR[iRoom]);
-		} else {
-			return (0);
-		}
-	} else if ((iTile >= 1) && (iTile <= 9)) {
-		if (arLinksU[iRoom] != 0)
-		{
-			return (arLinksU[iRoom]);
-		} else {
-			return (0);
-		}
-	} else { /*** iTile == 10 ***/
-		if (arLinksR[iRoom] != 0)
-		{
-			if (arLinksU[arLinksR[iRoom]] != 0)
-			{
-				return (arLinksU[arLinksR[iRoom]]);
-			} else {
-				return (0);
-			}
-		} else {
-			return (0);
-		}
-	}
+	arTileFlags[iChar] = iFlags;
+	arTileGlyph[iChar][0] = iW;
+	arTileGlyph[iChar][1] = iH;
+	arTileColor[iChar][0] = (iColor >> 16) & 0xff;
+	arTileColor[iChar][1] = (iColor >> 8) & 0xff;
+	arTileColor[iChar][2] = iColor & 0xff;
+	arTileStep[iChar] = iStep;
+	arTileDown[iChar] = iDown;
 }
 /*****************************************************************************/
-int GetTileLeft (int iRoom, int iTile)
+void ReadTiles (void)
 /*****************************************************************************/
 {
-	if ((iTile != 1) && (iTile != 11) && (iTile != 21))
-	{
-		return (iTile - 1);
-	} else if (arLinksL[iRoom] != 0) {
-		return (iTile + 9);
-	} else {
-		return (0);
-	}
+	/*** Reads the tiles.txt of a game, if it has one, on top of ***/
+	/*** arTileDefs. One tile per line: ***/
+	/*** <tile> <column> <row> <color> <flags> <step> <down> ***/
+	/*** The tile may be a range, such as a-r. The glyph is at column and ***/
+	/*** row (1-16) of png/8x16.png, the color is RRGGBB. Flags are the ***/
+	/*** names in arTileFlagName, separated by commas, or - for none. ***/
+	/*** Step and down, in arActName, are what happens when the prince ***/
+	/*** steps on the tile and when he presses Arrow Down on it. ***/
+	/*** For example, this makes & a red coin that hurts when drunk: ***/
+	/*** & 10 1 ff5555 floor coin hurt ***/
+
+	char sPathFile[MAX_PATHFILE + 2];
+	int iFd;
+	int iEOF;
+	char sLine[MAX_LINE + 2];
+
+	snprintf (sPathFile, MAX_PATHFILE, "%s%s%s%s%s",
+		DIR_GAMES, SLASH, arGames[iGameSel], SLASH, "tiles.txt");
+	iFd = open (sPathFile, O_RDONLY);
+	if (iFd == -1) { return; }
+	do {
+		iEOF = ReadLine (iFd, sLine);
+		AddTile (sLine);
+	} while (iEOF == 0);
+	close (iFd);
 }
 /*****************************************************************************/
-int GetTileRight (int iRoom, int iTile)
+void UseTiles (void)
 /*****************************************************************************/
 {
-	if ((iTile != 10) && (iTile != 20) && (iTile != 30))
-	{
-		return (iTile + 1);
-	} else if (arLinksR[iRoom] != 0) {
-		return (iTile - 9);
-	} else {
-		return (0);
-	}
+	/*** Builds the tile tables for iGameSel, when it differs from the ***/
+	/*** game they were built for. All games of a process share them, so ***/
+	/*** they must not change while one of them runs. ***/
+
+	if (iTilesGame == iGameSel) { return; }
+	BuildTiles();
+	ReadTiles();
+	iTilesGame = iGameSel;
 }
 /*****************************************************************************/
-int GetTileUp (int iRoom, int iTile)
+void AddTile (char *sLine)
 /*****************************************************************************/
 {
-	if (iTile > 10)
+	/*** Applies one line of ReadTiles(). ***/
+
+	char sTiles[MAX_LINE + 2];
+	char sFlags[MAX_LINE + 2];
+	char sStep[MAX_LINE + 2];
+	char sDown[MAX_LINE + 2];
+	char *sFlag;
+	int iFirst, iLast;
+	int iW, iH;
+	unsigned int iColor;
+	int iFlags, iBit, iStep, iDown;
+
+	/*** Used for looping. ***/
+	int iLoopChar;
+
+	if ((sscanf (sLine, "%s", sTiles) != 1) ||
+		(sTiles[0] == '#')) { return; } /*** Empty, or a comment. ***/
+	if (sscanf (sLine, "%s %i %i %x %s %s %s", sTiles, &iW, &iH, &iColor,
+		sFlags, sStep, sDown) != 7)
 	{
-		return (iTile - 10);
-	} else if (arLinksU[iRoom] != 0) {
-		return (iTile + 20);
-	} else {
-		return (0);
+		printf ("[ WARN ] Cannot use tile \"%s\"!\n", sLine);
+		return;
 	}
+	iFirst = (unsigned char)sTiles[0];
+	iLast = iFirst;
+	if ((strlen (sTiles) == 3) && (sTiles[1] == '-'))
+		{ iLast = (unsigned char)sTiles[2]; }
+	for (iStep = 0; iStep < ACTS; iStep++)
+		{ if (strcmp (sStep, arActName[iStep]) == 0) { break; } }
+	for (iDown = 0; iDown < ACTS; iDown++)
+		{ if (strcmp (sDown, arActName[iDown]) == 0) { break; } }
+	iFlags = 0;
+	if (strcmp (sFlags, "-") != 0)
+	{
+		for (sFlag = strtok (sFlags, ","); sFlag != NULL;
+			sFlag = strtok (NULL, ","))
+		{
+			for (iBit = 0; iBit < TILE_BITS; iBit++)
+				{ if (strcmp (sFlag, arTileFlagName[iBit]) == 0) { break; } }
+			if (iBit == TILE_BITS) { iFlags = -1; break; }
+			iFlags |= 1 << iBit;
+		}
+	}
+	if (((strlen (sTiles) != 1) && (iLast == iFirst)) || (iLast < iFirst) ||
+		(iW < 1) || (iW > 16) || (iH < 1) || (iH > 16) ||
+		(iColor > 0xffffff) || (iFlags == -1) || (iStep == ACTS) || (iDown == ACTS))
+	{
+		printf ("[ WARN ] Cannot use tile \"%s\"!\n", sLine);
+		return;
+	}
+
+	for (iLoopChar = iFirst; iLoopChar <= iLast; iLoopChar++)
+		{ SetTileDef (iLoopChar, iFlags, iW, iH, iColor, iStep, iDown); }
 }
 /*****************************************************************************/
-int GetTileDown (int iRoom, int iTile)
+int TileFlags (char cChar)
 /*****************************************************************************/
 {
-	if (iTile <= 20)
-	{
-		return (iTile + 10);
-	} else if (arLinksD[iRoom] != 0) {
-		return (iTile - 20);
-	} else {
-		return (0);
-	}
+	return (arTileFlags[(unsigned char)cChar]);
 }
 /*****************************************************************************/
-int GetTileUpLeft (int iRoom, int iTile)
+void BuildBoards (void)
 /*****************************************************************************/
 {
-	if (((iTile >= 12) && (iTile <= 20)) ||
-		((iTile >= 22) && (iTile <= 30)))
+	int iFlags;
+
+	/*** Used for looping. ***/
+	int iLoopRoom;
+	int iLoopTile;
+	int iLoopBoard;
+
+	memset (stGame->arBoard, 0, sizeof (stGame->arBoard));
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
 	{
-		return (iTile - 11);
-	} else if ((iTile == 11) || (iTile == 21)) {
-		if (arLinksL[iRoom] != 0)
-		{
-			return (iTile - 1);
-		} else {
-			return (0);
-		}
-	} else if ((iTile >= 2) && (iTile <= 10)) {
-		if (arLinksU[iRoom] != 0)
-		{
-			return (iTile + 19);
-		} else {
-			return (0);
-		}
-	} else { /*** iTile == 1 ***/
-		if (arLinksL[iRoom] != 0)
+		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
 		{
-			if (arLinksU[arLinksL[iRoom]] != 0)
+			iFlags = TileFlags (stGame->arTile[Cell (iLoopRoom, iLoopTile)]);
+			for (iLoopBoard = 0; iLoopBoard < BOARDS; iLoopBoard++)
 			{
-				return (30);
-			} else {
-				return (0);
+				if ((iFlags & arBoardFlag[iLoopBoard]) != 0)
+				{
+					stGame->arBoard[iLoopRoom][iLoopBoard] |=
+						(Uint32)1 << (iLoopTile - 1);
+				}
 			}
-		} else {
-			return (0);
 		}
 	}
 }
 /*****************************************************************************/
-int GetTileUpRight (int iRoom, int iTile)
+int FirstTile (Uint32 iBoard)
 /*****************************************************************************/
 {
-	if (((iTile >= 11) && (iTile <= 19)) ||
-		((iTile >= 21) && (iTile <= 29)))
-	{
-		return (iTile - 9);
-	} else if ((iTile == 20) || (iTile == 30)) {
-		if (arLinksR[iRoom] != 0)
-		{
-			return (iTile - 19);
-		} else {
-			return (0);
-		}
-	} else if ((iTile >= 1) && (iTile <= 9)) {
-		if (arLinksU[iRoom] != 0)
-		{
-			return (iTile + 21);
-		} else {
-			return (0);
-		}
-	} else { /*** iTile == 10 ***/
-		if (arLinksR[iRoom] != 0)
-		{
-			if (arLinksU[arLinksR[iRoom]] != 0)
-			{
-				return (21);
-			} else {
-				return (0);
-			}
-		} else {
-			return (0);
-		}
-	}
+	/*** Returns the tile of the lowest bit that is set. Not for 0. ***/
+
+#if defined __GNUC__
+	return (__builtin_ctz (iBoard) + 1);
+#else
+	int iTile;
+
+	iTile = 1;
+	while ((iBoard & 1) == 0) { iBoard >>= 1; iTile++; }
+	return (iTile);
+#endif
 }
 /*****************************************************************************/
 int IsEmpty (char cChar)
 /*****************************************************************************/
 {
-	switch (cChar)
-	{
-		case '.': return (1); break; /*** Empty. ***/
-		case '/': return (1); break; /*** Lattice top. ***/
-		case ':': return (1); break; /*** Pillar top. ***/
-		case '?': return (1); break; /*** Unknown tile. Converted to empty. ***/
-		case '\\': return (1); break; /*** Lattice (inc. small, left, right). ***/
-		case '`': return (1); break; /*** Empty with window. ***/
-	}
-
-	return (0);
+	return ((arTileFlags[(unsigned char)cChar] & TILE_EMPTY) != 0);
 }
 /*****************************************************************************/
 int IsFloor (char cChar)
 /*****************************************************************************/
 {
-	/*** What are NOT floors? ***/
-	switch (cChar)
+	return ((arTileFlags[(unsigned char)cChar] & TILE_FLOOR) != 0);
+}
+/*****************************************************************************/
+void BuildHazards (void)
+/*****************************************************************************/
+{
+	/*** Spikes come out if the prince is on or next to them, or above ***/
+	/*** them: one or two rows up, at most one column to the side. ***/
+	/*** Chompers chomp if they are on the row of the prince. ***/
+
+	Uint32 iPrinceBit, iNear, iColumns;
+
+	/*** Used for looping. ***/
+	int iLoopTile;
+
+	for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
 	{
-		case '#': return (0); break; /*** Wall (inc. floor with tapestry). ***/
-		case '%': return (0); break; /*** Mirror. ***/
-		case '(': return (0); break; /*** Gate top (inc. tapestry). ***/
-		case ')': return (0); break; /*** Gate (closed). ***/
-		case '.': return (0); break; /*** Empty. ***/
-		case '/': return (0); break; /*** Lattice top. ***/
-		case ':': return (0); break; /*** Pillar top. ***/
-		case '?': return (0); break; /*** Unknown tile. Converted to empty. ***/
-		case '\\': return (0); break; /*** Lattice (inc. small, left, right). ***/
-		case '`': return (0); break; /*** Empty with window. ***/
+		iPrinceBit = (Uint32)1 << (iLoopTile - 1);
+		iNear = iPrinceBit;
+		if (GetRoom (stGame->iCurRoom, iLoopTile, TO_LEFT) == stGame->iCurRoom)
+		{
+			iNear |= (Uint32)1 <<
+				(GetTile (stGame->iCurRoom, iLoopTile, TO_LEFT) - 1);
+		}
+		if (GetRoom (stGame->iCurRoom, iLoopTile, TO_RIGHT) == stGame->iCurRoom)
+		{
+			iNear |= (Uint32)1 <<
+				(GetTile (stGame->iCurRoom, iLoopTile, TO_RIGHT) - 1);
+		}
+		iColumns = iPrinceBit;
+		if ((iLoopTile % 10) != 1) { iColumns |= iPrinceBit >> 1; }
+		if ((iLoopTile % 10) != 0) { iColumns |= iPrinceBit << 1; }
+		stGame->arSpikesNear[iLoopTile] = (iNear | (iColumns << 10) |
+			(iColumns << 20)) & BOARD_ALL;
+		stGame->arChompRow[iLoopTile] =
+			(Uint32)0x3ff << (((iLoopTile - 1) / 10) * 10);
 	}
-
-	return (1);
+	stGame->iHazardRoom = stGame->iCurRoom;
 }
 /*****************************************************************************/
 void GameActions (void)
 /*****************************************************************************/
 {
-	char cSpike;
-	int iDown;
-	char cTile;
-	char cUpLeft, cUpRight;
+	Uint32 iSpikes, iChompers, iBoard;
+	int iTile;
 	int iChompBool;
 	int iChompNoise;
-	int iGrabbedLedge;
 	int iRoomLeft, iTileLeft;
 	int iRoomRight, iTileRight;
-	int iGuardBool;
+	Uint32 iPlayMs;
 
-	/*** Used for looping. ***/
-	int iLoopTile;
+	iRoomLeft = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+	iTileLeft = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+	iRoomRight = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
+	iTileRight = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
 
-	iRoomLeft = GetRoomLeft (iCurRoom, iPrinceTile);
-	iTileLeft = GetTileLeft (iCurRoom, iPrinceTile);
-	iRoomRight = GetRoomRight (iCurRoom, iPrinceTile);
-	iTileRight = GetTileRight (iCurRoom, iPrinceTile);
+	if (stGame->iHazardRoom != stGame->iCurRoom) { BuildHazards(); }
+	iPlayMs = stGame->iPlayTicks * REFRESH_GAME; /*** Not SDL_GetTicks(). ***/
 
 	/******************/
 	/* STEP 1: SPIKES */
 	/******************/
-	for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+	iSpikes = stGame->arBoard[stGame->iCurRoom][BOARD_SPIKES];
+	if (iSpikes != 0)
 	{
-		if ((arTiles[iCurRoom][iLoopTile] == '*') ||
-			(arTiles[iCurRoom][iLoopTile] == '^'))
+		iBoard = iSpikes & ~stGame->arSpikesNear[stGame->iPrinceTile];
+		while (iBoard != 0)
 		{
-			/*** cSpike ***/
-			cSpike = '*';
-			if ((iLoopTile >= 11) && (iLoopTile <= 30))
-			{
-				if (((iLoopTile - 10) == iPrinceTile) ||
-					((iLoopTile - 20) == iPrinceTile))
-					{ cSpike = '^'; }
-				if (((iLoopTile >= 12) && (iLoopTile <= 20)) ||
-					((iLoopTile >= 22) && (iLoopTile <= 30)))
-				{
-					if (((iLoopTile - 11) == iPrinceTile) ||
-						((iLoopTile - 21) == iPrinceTile)) { cSpike = '^'; }
-				}
-				if (((iLoopTile >= 11) && (iLoopTile <= 19)) ||
-					((iLoopTile >= 21) && (iLoopTile <= 29)))
-				{
-					if (((iLoopTile - 9) == iPrinceTile) ||
-						((iLoopTile - 19) == iPrinceTile)) { cSpike = '^'; }
-				}
-			}
-			/*** Prince next to, or on, spike. ***/
-			if (((iCurRoom == iRoomLeft) && (iLoopTile == iTileLeft)) ||
-				((iCurRoom == iRoomRight) && (iLoopTile == iTileRight)) ||
-				(iLoopTile == iPrinceTile))
-			{
-				cSpike = '^';
-			}
-
-			switch (cSpike)
+			iTile = FirstTile (iBoard);
+			iBoard&=iBoard - 1;
+			if (stGame->arTile[Cell (stGame->iCurRoom, iTile)] == '^')
+				{ SetTile (Cell (stGame->iCurRoom, iTile), '*'); }
+		}
+		iBoard = iSpikes & stGame->arSpikesNear[stGame->iPrinceTile];
+		while (iBoard != 0)
+		{
+			iTile = FirstTile (iBoard);
+			iBoard&=iBoard - 1;
+			if (stGame->arTile[Cell (stGame->iCurRoom, iTile)] == '*')
 			{
-				case '*':
-					if (arTiles[iCurRoom][iLoopTile] == '^')
-					{
-						arTiles[iCurRoom][iLoopTile] = '*';
-					}
-					break;
-				case '^':
-					if (arTiles[iCurRoom][iLoopTile] == '*')
-					{
-						arTiles[iCurRoom][iLoopTile] = '^';
-						PlaySound ("wav/spikes_out.wav");
-					}
-					break;
+				SetTile (Cell (stGame->iCurRoom, iTile), '^');
+				PlaySound ("wav/spikes_out.wav");
 			}
 		}
 	}
@@ -3734,469 +4435,876 @@ void GameActions (void)
 	/*******************/
 	/* STEP 2: CHOMPER */
 	/*******************/
-	iChompBool = (SDL_GetTicks() / 1000) % 2;
-	iChompNoise = 0;
-	for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+	iChompers = stGame->arBoard[stGame->iCurRoom][BOARD_CHOMPER];
+	if (iChompers != 0)
 	{
-		if (((iLoopTile >= 1) && (iLoopTile <= 10) &&
-			(iPrinceTile >= 1) && (iPrinceTile <= 10)) ||
-			((iLoopTile >= 11) && (iLoopTile <= 20) &&
-			(iPrinceTile >= 11) && (iPrinceTile <= 20)) ||
-			((iLoopTile >= 21) && (iLoopTile <= 30) &&
-			(iPrinceTile >= 21) && (iPrinceTile <= 30)))
+		iChompBool = (iPlayMs / 1000) % 2;
+		iChompNoise = 0;
+		iBoard = iChompers & ~stGame->arChompRow[stGame->iPrinceTile];
+		while (iBoard != 0)
+		{
+			iTile = FirstTile (iBoard);
+			iBoard&=iBoard - 1;
+			if (stGame->arTile[Cell (stGame->iCurRoom, iTile)] == '=')
+				{ SetTile (Cell (stGame->iCurRoom, iTile), '@'); }
+		}
+		iBoard = iChompers & stGame->arChompRow[stGame->iPrinceTile];
+		if (iBoard != 0) { iSolveClock = 1; }
+		while (iBoard != 0)
 		{
+			iTile = FirstTile (iBoard);
+			iBoard&=iBoard - 1;
 			if (iChompBool == 0)
 			{
-				if (arTiles[iCurRoom][iLoopTile] == '=')
-				{
-					arTiles[iCurRoom][iLoopTile] = '@';
-				}
+				if (stGame->arTile[Cell (stGame->iCurRoom, iTile)] == '=')
+					{ SetTile (Cell (stGame->iCurRoom, iTile), '@'); }
 			} else {
-				if (arTiles[iCurRoom][iLoopTile] == '@')
+				if (stGame->arTile[Cell (stGame->iCurRoom, iTile)] == '@')
 				{
 					if (iChompNoise == 0)
 					{
 						PlaySound ("wav/chomper.wav");
 						iChompNoise = 1;
 					}
-					arTiles[iCurRoom][iLoopTile] = '=';
+					SetTile (Cell (stGame->iCurRoom, iTile), '=');
 				}
 			}
-		} else {
-			if (arTiles[iCurRoom][iLoopTile] == '=')
-			{
-				arTiles[iCurRoom][iLoopTile] = '@';
-			}
 		}
 	}
 
 	/****************/
 	/* STEP 3: FALL */
 	/****************/
-	iDown = 0;
-	iGrabbedLedge = 0;
-	while ((IsEmpty (arTiles[iCurRoom][iPrinceTile]) == 1) &&
-		(iPrinceHang != 2) && (iCurLives != 0))
-	{
-		if (iPrinceTile <= 20)
-		{
-			iPrinceTile+=10;
-		} else if (arLinksD[iCurRoom] != 0) {
-			iCurRoom = arLinksD[iCurRoom];
-			iPrinceTile-=20;
-		} else {
-			/*** Special events related. ***/
-			if ((iCurLevel == 6) && (iCurRoom == 3))
-			{
-				iCurLevel++;
-				LoadLevel (iCurLevel, iMaxLives);
-				return;
-			} else { /*** No room below, nor a special event. ***/
-				iCurLives = 0;
-				iFlash = 10;
-				iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
-			}
-		}
-		SDL_Delay (100);
-		ShowGame();
-		iDown++;
-		if ((iDown == 3) && (iPrinceFloat == 0)) { PlaySound ("wav/scream.wav"); }
-
-		cUpLeft = GetCharUpLeft (iCurRoom, iPrinceTile);
-		cUpRight = GetCharUpRight (iCurRoom, iPrinceTile);
-/***
-This cannot be used, because of e.g. level 7, room 14:
-if ((iPrinceHang == 1) &&
-	(((iPrinceDir == 1) && (IsFloor (cUpLeft) == 1)) ||
-	((iPrinceDir == 2) && (IsFloor (cUpRight) == 1))))
-***/
-		if ((iPrinceHang == 1) &&
-			(IsFloor (arTiles[iCurRoom][iPrinceTile]) != 1) &&
-			(((IsFloor (cUpLeft) == 1) && (cUpLeft != '>') && (cUpLeft != '<')) ||
-			((IsFloor (cUpRight) == 1) && (cUpRight != '>') && (cUpRight != '<'))))
-		{
-			/*** Turn around if necessary. ***/
-			switch (iPrinceDir)
-			{
-				case 1: /*** left ***/
-					if (IsFloor (cUpLeft) == 0) { iPrinceDir = 2; }
-					break;
-				case 2: /*** right ***/
-					if (IsFloor (cUpRight) == 0) { iPrinceDir = 1; }
-			}
-
-			PlaySound ("wav/grab.wav");
-			iGrabbedLedge = 1;
-			iPrinceHang = 2;
-		}
-	}
-	switch (iDown)
+	if ((stGame->iPrinceFall == 0) && (InFall() == 1))
 	{
-		case 0:
-			break;
-		case 1:
-			if (iGrabbedLedge == 0)
-			{
-				PlaySound ("wav/landing_soft.wav");
-			}
-			break;
-		case 2:
-			if (iGrabbedLedge == 0)
-			{
-				if (iPrinceFloat == 0)
-				{
-					iCurLives--;
-					if (iCurLives != 0)
-					{
-						PlaySound ("wav/landing_hurt.wav");
-					} else {
-						PlaySound ("wav/landing_dead.wav");
-					}
-					iFlash = 10;
-					iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
-				} else {
-					PlaySound ("wav/landing_soft.wav");
-				}
-			}
-			break;
-		default:
-			if (iPrinceFloat == 0)
-			{
-				iCurLives = 0;
-				PlaySound ("wav/landing_dead.wav");
-				iFlash = 10;
-				iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
-			} else {
-				PlaySound ("wav/landing_soft.wav");
-			}
-			break;
+		stGame->iPrinceFall = 1;
+		stGame->iPrinceFallRows = 0;
 	}
+	/*** FallPrince() moves him down; the steps below wait until he lands. ***/
+	if (stGame->iPrinceFall == 1) { return; }
 
 	/*****************/
 	/* STEP 4: TILES */
 	/*****************/
-	cTile = arTiles[iCurRoom][iPrinceTile];
-	switch (cTile)
-	{
-		case '^': /*** Spikes (out). Harmful. ***/
-			if (iPrinceSafe == 0)
-			{
-				PlaySound ("wav/spikes_death_b.wav");
-				iCurLives = 0;
-				iFlash = 10;
-				iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
-			}
-			break;
-		case '~': /*** Loose floor (inc. stuck). ***/
-			DropLoose (iCurRoom, iPrinceTile);
-			break;
-		case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-		case 'G': case 'H': case 'I': case 'J': case 'K': case 'L':
-		case 'M': case 'N': case 'O': case 'P': case 'Q': case 'R':
-			/*** Raise buttons A - R (18). ***/
-			PushButton (cTile, 0);
-			break;
-		case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-		case 'g': case 'h': case 'i': case 'j': case 'k': case 'l':
-		case 'm': case 'n': case 'o': case 'p': case 'q': case 'r':
-			/*** Drop buttons a - r (18). ***/
-			PushButton (cTile, 0);
-			break;
-		case '=': /*** Chomper (closed). ***/
-			PlaySound ("wav/chomper_death.wav");
-			iCurLives = 0;
-			iFlash = 10;
-			iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
-			break;
-		case '$': /*** Coin on floor. ***/
-			arTiles[iCurRoom][iPrinceTile] = '_';
-			iPrinceCoins++;
-			PlaySound ("wav/coin.wav");
-			iShowStepsCoins = 1;
-			iFlash = 10;
-			iFlashR = 0xff; iFlashG = 0xff; iFlashB = 0x55;
-			break;
-		case '8': /*** Fake wall (floor that looks like a wall). ***/
-			arTiles[iCurRoom][iPrinceTile] = '_';
-			break;
-		case '9': /*** Fake empty (floor that looks empty). ***/
-			arTiles[iCurRoom][iPrinceTile] = '_';
-			break;
-		case '&': /*** Custom Puny Prince tile. ***/
-			/* CUSTOM INFO
-			 * Add code below if something should happen when the player steps
-			 * on a custom tile.
-			 */
-			break;
-	}
+	TileAction (arTileStep[(unsigned char)stGame->arTile[PrinceCell()]],
+		PrinceCell());
+
+	/*****************/
+	/* STEP 5: SWORD */
+	/*****************/
+	if (stGame->iPrinceSword == 2) { SwordHit(); }
 
 	/*************************/
-	/* STEP 5: GUARD ATTACKS */
+	/* STEP 6: GUARD ATTACKS */
 	/*************************/
-	if ((arGuardLoc[iCurRoom] == iPrinceTile) &&
-		(arGuardHP[iCurRoom] != 0) && (arGuardType[iCurRoom] <= 3))
+	GuardsAttack (stGame->iCurRoom, stGame->iPrinceTile, 0, iPlayMs);
+	GuardsAttack (iRoomRight, iTileRight, TO_RIGHT, iPlayMs);
+	GuardsAttack (iRoomLeft, iTileLeft, TO_LEFT, iPlayMs);
+
+	/***************/
+	/* STEP 7: DIE */
+	/***************/
+	if (stGame->iCurLives == 0)
+	{
+		Die();
+	}
+}
+/*****************************************************************************/
+void SwordHit (void)
+/*****************************************************************************/
+{
+	/*** The sword is out; it hits a guard in front, in the same room. ***/
+
+	int iSwordRoom, iSwordTile;
+	int iGuard;
+
+	if (stGame->iPrinceDir == 1)
 	{
-		iCurLives = 0;
-		PlaySound ("wav/hit_prince.wav");
-		iFlash = 10;
-		iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
+		iSwordRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+		iSwordTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_LEFT);
+	} else {
+		iSwordRoom = GetRoom (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
+		iSwordTile = GetTile (stGame->iCurRoom, stGame->iPrinceTile, TO_RIGHT);
 	}
-	if ((arGuardLoc[iRoomRight] == iTileRight) &&
-		(arGuardHP[iRoomRight] != 0))
+	if (iSwordRoom != stGame->iCurRoom) { return; }
+	iGuard = GuardAt (iSwordRoom, iSwordTile);
+	if ((iGuard == -1) || (stGame->arGuardHP[iGuard] == 0)) { return; }
+
+	stGame->iHash ^= ZobristGuard (iGuard);
+	stGame->arGuardHP[iGuard]--;
+	stGame->iHash ^= ZobristGuard (iGuard);
+	PlaySound ("wav/hit_guard.wav");
+	stGame->iPrinceSword = 1;
+	if (stGame->arGuardHP[iGuard] == 0)
+		{ RunTriggers (TRIG_KILL, iSwordRoom, iSwordTile); }
+}
+/*****************************************************************************/
+int AddGuard (int iRoom, int iTile, int iType, int iHP)
+/*****************************************************************************/
+{
+	/*** Puts a guard on iRoom, iTile, instead of any guard there. ***/
+	/*** Returns the guard, or -1 if there is no room for it. ***/
+
+	int iGuard;
+
+	if ((iRoom < 1) || (iRoom > ROOMS)) { return (-1); }
+	iGuard = GuardAt (iRoom, iTile);
+	if (iGuard == -1)
 	{
-		switch (arGuardType[iRoomRight])
+		if (stGame->iNrGuards == MAX_GUARDS)
 		{
-			case 1: iGuardBool = (SDL_GetTicks() / 500) % 2; break; /*** E ***/
-			case 2: iGuardBool = (SDL_GetTicks() / 250) % 2; break; /*** H ***/
-			case 3: iGuardBool = (SDL_GetTicks() / 200) % 2; break; /*** J ***/
-			default: iGuardBool = 0;
+			printf ("[ WARN ] Level %i: too many guards.\n", stGame->iCurLevel);
+			return (-1);
 		}
-		if (iGuardBool == 0)
+		iGuard = stGame->iNrGuards++;
+		stGame->arGuardRoom[iGuard] = iRoom;
+		stGame->arGuardLoc[iGuard] = iTile;
+		stGame->arRoomGuards[iRoom] |= (Uint64)1 << iGuard;
+	} else {
+		stGame->iHash ^= ZobristGuard (iGuard);
+	}
+	stGame->arGuardType[iGuard] = iType;
+	stGame->arGuardHP[iGuard] = iHP;
+	stGame->arGuardAttack[iGuard] = 0;
+	stGame->iHash ^= ZobristGuard (iGuard);
+
+	return (iGuard);
+}
+/*****************************************************************************/
+int GuardAt (int iRoom, int iTile)
+/*****************************************************************************/
+{
+	/*** Returns a living guard on iRoom, iTile, else a dead one, else -1. ***/
+
+	Uint64 iGuards;
+	int iGuard, iDead;
+
+	iDead = -1;
+	for (iGuards = stGame->arRoomGuards[iRoom]; iGuards != 0;
+		iGuards &= iGuards - 1)
+	{
+		iGuard = FirstGuard (iGuards);
+		if (stGame->arGuardLoc[iGuard] != iTile) { continue; }
+		if (stGame->arGuardHP[iGuard] != 0) { return (iGuard); }
+		iDead = iGuard;
+	}
+
+	return (iDead);
+}
+/*****************************************************************************/
+int FirstGuard (Uint64 iGuards)
+/*****************************************************************************/
+{
+	/*** Returns the guard of the lowest bit that is set. Not for 0. ***/
+
+#if defined __GNUC__
+	return (__builtin_ctzll (iGuards));
+#else
+	int iGuard;
+
+	iGuard = 0;
+	while ((iGuards & 1) == 0) { iGuards >>= 1; iGuard++; }
+	return (iGuard);
+#endif
+}
+/*****************************************************************************/
+int LivingGuards (int iRoom)
+/*****************************************************************************/
+{
+	Uint64 iGuards;
+	int iLiving;
+
+	iLiving = 0;
+	for (iGuards = stGame->arRoomGuards[iRoom]; iGuards != 0;
+		iGuards &= iGuards - 1)
+		{ if (stGame->arGuardHP[FirstGuard (iGuards)] != 0) { iLiving++; } }
+
+	return (iLiving);
+}
+/*****************************************************************************/
+void GuardsAttack (int iRoom, int iTile, int iSide, Uint32 iPlayMs)
+/*****************************************************************************/
+{
+	/*** The living guards on iRoom, iTile attack the prince. On his own ***/
+	/*** tile (iSide 0) they kill him; next to him, they hit in rhythm. ***/
+
+	Uint64 iGuards;
+	int iGuard;
+	int iGuardBool;
+
+	for (iGuards = stGame->arRoomGuards[iRoom]; iGuards != 0;
+		iGuards &= iGuards - 1)
+	{
+		iGuard = FirstGuard (iGuards);
+		if ((stGame->arGuardLoc[iGuard] != iTile) ||
+			(stGame->arGuardHP[iGuard] == 0)) { continue; }
+		if (iSide == 0)
 		{
-			arGuardAttack[iRoomRight] = 0;
-		} else {
-			if (arGuardAttack[iRoomRight] == 0)
+			if (stGame->arGuardType[iGuard] <= 3)
 			{
-				iCurLives--;
+				stGame->iCurLives = 0;
 				PlaySound ("wav/hit_prince.wav");
-				arGuardAttack[iRoomRight] = 1;
-				iFlash = 10;
-				iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
+				Flash (0xaa, 0x00, 0x00);
 			}
+			continue;
 		}
-	}
-	if ((arGuardLoc[iRoomLeft] == iTileLeft) &&
-		(arGuardHP[iRoomLeft] != 0))
-	{
-		switch (arGuardType[iRoomLeft])
+		switch (stGame->arGuardType[iGuard])
 		{
-			case 1: iGuardBool = (SDL_GetTicks() / 500) % 2; break; /*** easy ***/
-			case 2: iGuardBool = (SDL_GetTicks() / 250) % 2; break; /*** hard ***/
+			case 1: iGuardBool = (iPlayMs / 500) % 2; break; /*** E ***/
+			case 2: iGuardBool = (iPlayMs / 250) % 2; break; /*** H ***/
+			case 3: /*** J, only from the right. ***/
+				iGuardBool = (iSide == TO_RIGHT) ? (iPlayMs / 200) % 2 : 0;
+				break;
 			default: iGuardBool = 0;
 		}
+		if ((stGame->arGuardType[iGuard] <= 2) ||
+			((stGame->arGuardType[iGuard] == 3) && (iSide == TO_RIGHT)))
+			{ iSolveClock = 1; } /*** For the solver; see SolveNode(). ***/
 		if (iGuardBool == 0)
 		{
-			arGuardAttack[iRoomLeft] = 0;
+			stGame->arGuardAttack[iGuard] = 0;
 		} else {
-			if (arGuardAttack[iRoomLeft] == 0)
+			if (stGame->arGuardAttack[iGuard] == 0)
 			{
-				iCurLives--;
+				stGame->iCurLives--;
 				PlaySound ("wav/hit_prince.wav");
-				arGuardAttack[iRoomLeft] = 1;
-				iFlash = 10;
-				iFlashR = 0xaa; iFlashG = 0x00; iFlashB = 0x00;
+				stGame->arGuardAttack[iGuard] = 1;
+				Flash (0xaa, 0x00, 0x00);
 			}
 		}
 	}
+}
+/*****************************************************************************/
+void KillGuards (int iRoom)
+/*****************************************************************************/
+{
+	/*** For the cheat key. ***/
 
-	/***************/
-	/* STEP 6: DIE */
-	/***************/
-	if (iCurLives == 0)
+	Uint64 iGuards;
+	int iGuard;
+
+	for (iGuards = stGame->arRoomGuards[iRoom]; iGuards != 0;
+		iGuards &= iGuards - 1)
 	{
-		Die();
+		iGuard = FirstGuard (iGuards);
+		if (stGame->arGuardHP[iGuard] == 0) { continue; }
+		stGame->iHash ^= ZobristGuard (iGuard);
+		stGame->arGuardHP[iGuard] = 0;
+		stGame->iHash ^= ZobristGuard (iGuard);
+		if (RunTriggers (TRIG_KILL, iRoom, stGame->arGuardLoc[iGuard]) == 1)
+			{ return; }
+	}
+}
+/*****************************************************************************/
+void FallPrince (void)
+/*****************************************************************************/
+{
+	char cUpLeft, cUpRight;
+
+	/*** One row per game tick. ***/
+	if (stGame->iPrinceFall == 0) { return; }
+	if (stGame->iPrinceTile <= 20)
+	{
+		stGame->iPrinceTile+=10;
+	} else if (stGame->arLinksD[stGame->iCurRoom] != 0) {
+		stGame->iCurRoom = stGame->arLinksD[stGame->iCurRoom];
+		stGame->iPrinceTile-=20;
+	} else {
+		if (RunTriggers (TRIG_FALL, stGame->iCurRoom,
+			stGame->iPrinceTile) == 1) { return; }
+		/*** No room below, nor a special event. ***/
+		stGame->iCurLives = 0;
+		Flash (0xaa, 0x00, 0x00);
+	}
+	stGame->iPrinceFallRows++;
+	if ((stGame->iPrinceFallRows == 3) && (stGame->iPrinceFloat == 0))
+		{ PlaySound ("wav/scream.wav"); }
+
+	cUpLeft = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_UPLEFT);
+	cUpRight = GetChar (stGame->iCurRoom, stGame->iPrinceTile, TO_UPRIGHT);
+/***
+This cannot be used, because of e.g. level 7, room 14:
+if ((stGame->iPrinceHang == 1) &&
+(((stGame->iPrinceDir == 1) && (IsFloor (cUpLeft) == 1)) ||
+((stGame->iPrinceDir == 2) && (IsFloor (cUpRight) == 1))))
+***/
+	if ((stGame->iPrinceHang == 1) &&
+		(IsFloor (stGame->arTile[PrinceCell()]) != 1) &&
+		(((TileFlags (cUpLeft) & (TILE_FLOOR | TILE_PLATFORM)) == TILE_FLOOR) ||
+		((TileFlags (cUpRight) & (TILE_FLOOR | TILE_PLATFORM)) == TILE_FLOOR)))
+	{
+		/*** Turn around if necessary. ***/
+		switch (stGame->iPrinceDir)
+		{
+			case 1: /*** left ***/
+				if (IsFloor (cUpLeft) == 0) { stGame->iPrinceDir = 2; }
+				break;
+			case 2: /*** right ***/
+				if (IsFloor (cUpRight) == 0) { stGame->iPrinceDir = 1; }
+		}
+
+		PlaySound ("wav/grab.wav");
+		stGame->iPrinceHang = 2;
+	}
+
+	/*** Landed, grabbed a ledge, or died. ***/
+	if (InFall() == 1) { return; }
+	stGame->iPrinceFall = 0;
+	switch (stGame->iPrinceFallRows)
+	{
+		case 1:
+			if (stGame->iPrinceHang != 2)
+			{
+				PlaySound ("wav/landing_soft.wav");
+			}
+			break;
+		case 2:
+			if (stGame->iPrinceHang != 2)
+			{
+				if (stGame->iPrinceFloat == 0)
+				{
+					stGame->iCurLives--;
+					if (stGame->iCurLives != 0)
+					{
+						PlaySound ("wav/landing_hurt.wav");
+					} else {
+						PlaySound ("wav/landing_dead.wav");
+					}
+					Flash (0xaa, 0x00, 0x00);
+				} else {
+					PlaySound ("wav/landing_soft.wav");
+				}
+			}
+			break;
+		default:
+			if (stGame->iPrinceFloat == 0)
+			{
+				stGame->iCurLives = 0;
+				PlaySound ("wav/landing_dead.wav");
+				Flash (0xaa, 0x00, 0x00);
+			} else {
+				PlaySound ("wav/landing_soft.wav");
+			}
+			break;
 	}
 }
 /*****************************************************************************/
+int InFall (void)
+/*****************************************************************************/
+{
+	/*** Returns 1 if the prince is above empty, not hanging, and alive. ***/
+
+	if ((((stGame->arBoard[stGame->iCurRoom][BOARD_EMPTY] >>
+		(stGame->iPrinceTile - 1)) & 1) == 1) && (stGame->iPrinceHang != 2) &&
+		(stGame->iCurLives != 0)) { return (1); }
+
+	return (0);
+}
+/*****************************************************************************/
 void PushButton (char cChar, int iForever)
 /*****************************************************************************/
 {
 	int iRoom, iTile;
+	int iCell;
+	int iRight;
 	int iFrames;
+	int iFlags;
 
 	/*** Used for looping. ***/
-	int iLoopEvent;
+	int iLoopTarget;
 
 	if (iForever == 0)
 	{
-		iFrames = 125; /*** = 10 seconds ***/
+		iFrames = GATE_TICKS;
 	} else {
-		iFrames = 45000; /*** = 1 hour, should be enough ***/
+		iFrames = GATE_FOREVER;
 	}
 
+	iFlags = TileFlags (cChar);
+
 	/*** Raise. ***/
-	if ((cChar >= 'A') && (cChar <= 'R'))
+	if ((iFlags & (TILE_BUTTON | TILE_RAISE)) == (TILE_BUTTON | TILE_RAISE))
 	{
-		for (iLoopEvent = 1; iLoopEvent <= 10; iLoopEvent++)
+		for (iLoopTarget = stGame->arButtonFirst[(unsigned char)cChar];
+			iLoopTarget < stGame->arButtonFirst[(unsigned char)cChar + 1];
+			iLoopTarget++)
 		{
-			iRoom = arLettersRoom[(int)cChar][iLoopEvent];
-			iTile = arLettersTile[(int)cChar][iLoopEvent];
-			if (arTiles[iRoom][iTile] == ')')
+			iCell = stGame->arTargets[iLoopTarget];
+			iRoom = iCell / ROOM_CELLS;
+			iTile = arCellTile[iCell % ROOM_CELLS];
+			if (stGame->arTile[Cell (iRoom, iTile)] == ')')
 			{
 				PlaySound ("wav/gate_open.wav");
-				arTiles[iRoom][iTile] = '"';
-				arGateTimers[iRoom][iTile] = iFrames;
-				/*** Special events related. ***/
-				if ((iCurLevel == 5) && (iRoom == 24) && (iTile == 2))
-				{
-					arGuardLoc[iRoom] = 4;
-					arGuardType[iRoom] = 4;
-					arGuardHP[iRoom] = iMaxLives;
-					arGuardAttack[iRoom] = 0;
-					/***/
-					if ((arTiles[24][4] >= '0') && (arTiles[24][4] <= '6'))
-					{
-						arTiles[24][4] = '_';
-						PlaySound ("wav/drinking.wav");
-					}
-				}
-			} else if (arTiles[iRoom][iTile] == '"') {
-				arGateTimers[iRoom][iTile] = iFrames;
+				SetTile (Cell (iRoom, iTile), '"');
+				StartGateTimer (iRoom, iTile, iFrames);
+				RunTriggers (TRIG_GATE, iRoom, iTile);
+			} else if (stGame->arTile[Cell (iRoom, iTile)] == '"') {
+				StartGateTimer (iRoom, iTile, iFrames);
 			}
 
 			/*** Level door left/right. ***/
-			if (arTiles[iRoom][iTile] == '[')
+			if (stGame->arTile[Cell (iRoom, iTile)] == '[')
 			{
-				if (iCoinsInLevel == iPrinceCoins)
+				if (stGame->iCoinsInLevel == stGame->iPrinceCoins)
 				{
 					PlaySound ("wav/level_door_open.wav");
-					arTiles[iRoom][iTile] = '{';
-					if ((iTile != 10) && (iTile != 20) && (iTile != 30))
-					{
-						if (arTiles[iRoom][iTile + 1] == ']')
-							{ arTiles[iRoom][iTile + 1] = '}'; }
-					} else if (arLinksR[iRoom] != 0) {
-						if (arTiles[arLinksR[iRoom]][iTile - 9] == ']')
-							{ arTiles[arLinksR[iRoom]][iTile - 9] = '}'; }
-					}
-					/*** Special events related. ***/
-					switch (iCurLevel)
-					{
-						case 4: iMirror = 1; break;
-						case 8: iMouse = 1; break;
-					}
-				} else if (iNoMessage == 0) {
+					SetTile (Cell (iRoom, iTile), '{');
+					iRight = stGame->arReal[Cell (iRoom, iTile) + 1];
+					if ((iRight != 0) && (stGame->arTile[iRight] == ']'))
+						{ SetTile (iRight, '}'); }
+					RunTriggers (TRIG_DOOR, iRoom, iTile);
+				} else if (stGame->iNoMessage == 0) {
 					snprintf (sMessage, MAX_MESSAGE, "Coins collected: %i / %i",
-						iPrinceCoins, iCoinsInLevel);
-					SDL_ShowSimpleMessageBox (SDL_MESSAGEBOX_INFORMATION,
-						"Note", sMessage, window);
-					iNoMessage = 1;
+						stGame->iPrinceCoins, stGame->iCoinsInLevel);
+					Message (sMessage);
+					stGame->iNoMessage = 1;
 				}
 			}
 		}
 	}
 
 	/*** Drop. ***/
-	if ((cChar >= 'a') && (cChar <= 'r'))
+	if ((iFlags & (TILE_BUTTON | TILE_RAISE)) == TILE_BUTTON)
 	{
-		for (iLoopEvent = 1; iLoopEvent <= 10; iLoopEvent++)
+		for (iLoopTarget = stGame->arButtonFirst[(unsigned char)cChar];
+			iLoopTarget < stGame->arButtonFirst[(unsigned char)cChar + 1];
+			iLoopTarget++)
 		{
-			iRoom = arLettersRoom[(int)cChar][iLoopEvent];
-			iTile = arLettersTile[(int)cChar][iLoopEvent];
-			if (arTiles[iRoom][iTile] == '"')
+			iCell = stGame->arTargets[iLoopTarget];
+			if (stGame->arTile[iCell] == '"')
 			{
-				arTiles[iRoom][iTile] = ')';
+				SetTile (iCell, ')');
 				PlaySound ("wav/gate_close_fast.wav");
 			}
 		}
 	}
 }
 /*****************************************************************************/
-void Die (void)
+int RunTriggers (int iEvent, int iRoom, int iTile)
 /*****************************************************************************/
 {
-	ShowGame();
-	SDL_Delay (1000);
-	LoadLevel (iCurLevel, iMaxLives - iLevLives);
+	/*** Returns 1 if a trigger started a sequence. ***/
+
+	struct trigger *stTrigger;
+
+	/*** Used for looping. ***/
+	int iLoopTrigger;
+
+	if ((stGame->arTrigRooms[iEvent] & (((Uint32)1 << iRoom) | 1)) == 0)
+		{ return (0); }
+
+	for (iLoopTrigger = 1; iLoopTrigger <= stGame->iNrTriggers; iLoopTrigger++)
+	{
+		stTrigger = &stGame->arTrigger[iLoopTrigger];
+		if ((stTrigger->iEvent != iEvent) ||
+			((stTrigger->iRoom != 0) && (stTrigger->iRoom != iRoom)) ||
+			((stTrigger->iTile != 0) && (stTrigger->iTile != iTile))) { continue; }
+		if (RunCode (stTrigger->iCode, iRoom, iTile) == 1) { return (1); }
+	}
+
+	return (0);
 }
 /*****************************************************************************/
-void BossKey (void)
+int RunCode (int iCode, int iRoom, int iTile)
 /*****************************************************************************/
 {
-	int iBossKey;
-	SDL_Event event;
+	/*** Runs the instructions of a trigger, for an event on iRoom, ***/
+	/*** iTile. Returns 1 if they started a sequence. ***/
 
-	iBossKey = 1;
+	Sint16 *arArg;
+	int iCell;
+	char cChar;
+	int iGuard;
 
-	ShowBossKey();
-	while (iBossKey == 1)
+	for (;;)
 	{
-		/*** This is for the animation. ***/
-		newticks = SDL_GetTicks();
-		if (newticks > oldticks + REFRESH_GAME)
+		arArg = &stGame->arTrigCode[iCode + 1];
+		iCell = 0;
+		if (arCodeDefs[stGame->arTrigCode[iCode]].iCell == 1)
+			{ iCell = Cell (arArg[0], arArg[1]); }
+		switch (stGame->arTrigCode[iCode])
 		{
-			ShowBossKey();
-			oldticks = newticks;
+			case CODE_END: return (0);
+			case CODE_GUARD:
+				AddGuard (arArg[0], arArg[1], arArg[2], stGame->iMaxLives);
+				break;
+			case CODE_MOVEGUARD:
+				if (stGame->arRoomGuards[arArg[0]] != 0)
+				{
+					iGuard = FirstGuard (stGame->arRoomGuards[arArg[0]]);
+					stGame->iHash ^= ZobristGuard (iGuard);
+					stGame->arGuardLoc[iGuard] = arArg[1];
+					stGame->iHash ^= ZobristGuard (iGuard);
+				}
+				break;
+			case CODE_PRESS:
+				cChar = stGame->arTile[iCell];
+				if ((TileFlags (cChar) & TILE_BUTTON) != 0)
+					{ PushButton (cChar, 0); }
+				break;
+			case CODE_CRUSH:
+				cChar = stGame->arTile[iCell];
+				if ((TileFlags (cChar) & TILE_BUTTON) != 0)
+				{
+					PushButton (cChar, 1);
+					SetTile (iCell, '-');
+				}
+				break;
+			case CODE_TILE:
+				SetTile (iCell, arArg[2]);
+				break;
+			case CODE_DRINK:
+				if ((TileFlags (stGame->arTile[iCell]) & TILE_POTION) != 0)
+				{
+					SetTile (iCell, '_');
+					PlaySound ("wav/drinking.wav");
+				}
+				break;
+			case CODE_FLASH:
+				Flash (arArg[0], arArg[1], arArg[2]);
+				break;
+			case CODE_LEVEL:
+				StartSequence (SEQ_LEVEL, LEVEL_TICKS);
+				return (1);
+			case CODE_VICTORY:
+				if (iHeadless == 0)
+				{
+					printf ("[ INFO ] Victory! You used %i steps.\n",
+						stGame->iSteps);
+				}
+				stGame->iShowStepsCoins = 1;
+				StartSequence (SEQ_VICTORY, VICTORY_TICKS);
+				return (1);
+			case CODE_FACE:
+				stGame->iPrinceDir = arArg[0];
+				break;
+			case CODE_HANG:
+				stGame->iPrinceHang = 1;
+				break;
+			case CODE_SET:
+			case CODE_ADD:
+				stGame->iHash ^= ZobristFlag (arArg[0], stGame->arFlag[arArg[0]]);
+				if (stGame->arTrigCode[iCode] == CODE_SET)
+				{
+					stGame->arFlag[arArg[0]] = arArg[1];
+				} else {
+					stGame->arFlag[arArg[0]]+=arArg[1];
+				}
+				stGame->iHash ^= ZobristFlag (arArg[0], stGame->arFlag[arArg[0]]);
+				break;
+			case CODE_IFEQ:
+				if (stGame->arFlag[arArg[0]] != arArg[1]) { return (0); }
+				break;
+			case CODE_IFGT:
+				if (stGame->arFlag[arArg[0]] <= arArg[1]) { return (0); }
+				break;
+			case CODE_IFRUN:
+				if (stGame->iRunJump != 1) { return (0); }
+				break;
+			case CODE_IFDIR:
+				if (stGame->iPrinceDir != arArg[0]) { return (0); }
+				break;
+			case CODE_IFFROM:
+				if (stGame->iCurRoom != arArg[0]) { return (0); }
+				break;
+			case CODE_IFGUARD:
+				iGuard = GuardAt (iRoom, iTile);
+				if ((iGuard == -1) || (stGame->arGuardType[iGuard] != arArg[0]))
+					{ return (0); }
+				break;
+			case CODE_IFSIDE:
+				if (stGame->iGoSide != 1) { return (0); }
+				break;
 		}
+		iCode+=arCodeDefs[stGame->arTrigCode[iCode]].iArgs + 1;
+	}
+}
+/*****************************************************************************/
+int TriggerEnds (int iEvent, int iCell)
+/*****************************************************************************/
+{
+	/*** Returns 1 if a trigger for iCell may end the level, no matter ***/
+	/*** its if* instructions. For AnalyzeLevel(). ***/
 
-		while (SDL_PollEvent (&event))
+	struct trigger *stTrigger;
+	int iRoom, iTile;
+	int iCode;
+
+	/*** Used for looping. ***/
+	int iLoopTrigger;
+
+	iRoom = iCell / ROOM_CELLS;
+	iTile = arCellTile[iCell % ROOM_CELLS];
+	for (iLoopTrigger = 1; iLoopTrigger <= stGame->iNrTriggers; iLoopTrigger++)
+	{
+		stTrigger = &stGame->arTrigger[iLoopTrigger];
+		if ((stTrigger->iEvent != iEvent) ||
+			((stTrigger->iRoom != 0) && (stTrigger->iRoom != iRoom)) ||
+			((stTrigger->iTile != 0) && (stTrigger->iTile != iTile))) { continue; }
+		iCode = stTrigger->iCode;
+		while (stGame->arTrigCode[iCode] != CODE_END)
 		{
-			switch (event.type)
-			{
-				case SDL_KEYDOWN:
-					switch (event.key.keysym.sym)
-					{
-						case SDLK_F9:
-							iBossKey = 0;
-							break;
-					}
-					break;
-				case SDL_WINDOWEVENT:
-					if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
-						{ ShowGame(); ShowBossKey(); } break;
-				case SDL_QUIT:
-					Quit(); break;
-			}
+			if ((stGame->arTrigCode[iCode] == CODE_LEVEL) ||
+				(stGame->arTrigCode[iCode] == CODE_VICTORY)) { return (1); }
+			iCode+=arCodeDefs[stGame->arTrigCode[iCode]].iArgs + 1;
 		}
-
-		PreventCPUEating();
 	}
 
-	ShowGame();
+	return (0);
 }
 /*****************************************************************************/
-void ShowBossKey (void)
+void Die (void)
 /*****************************************************************************/
 {
-	ShowImage (imgscreend, 0, 0, "imgscreend");
-	ShowImage (imgblack, 102, 8, "imgblack");
+	StartSequence (SEQ_DEATH, DEATH_TICKS);
+}
+/*****************************************************************************/
+void StartSequence (int iSeq, int iTicks)
+/*****************************************************************************/
+{
+	stGame->iSequence = iSeq;
+	stGame->iSequenceTicks = iTicks;
+	if (iNoWait == 1) { EndSequence(); }
+}
+/*****************************************************************************/
+void RunSequence (void)
+/*****************************************************************************/
+{
+	stGame->iSequenceTotal++;
+	stGame->iSequenceTicks--;
+	if (stGame->iSequenceTicks <= 0) { EndSequence(); }
+}
+/*****************************************************************************/
+void EndSequence (void)
+/*****************************************************************************/
+{
+	int iSeq;
 
-	ShowText (1, "C:\\>", 0xaa, 0xaa, 0xaa, 0);
-	if ((SDL_GetTicks() / 500) % 2 == 0)
+	iSeq = stGame->iSequence;
+	stGame->iSequence = SEQ_NONE;
+	switch (iSeq)
 	{
-		/*** _ ***/
-		ShowChar (16, 6, 0xaa, 0xaa, 0xaa,
-			102 + (4 * (arWidth[4] * 2)), 8, 4, 2, 0);
+		case SEQ_DEATH:
+			LoadLevel (stGame->iCurLevel, stGame->iMaxLives - stGame->iLevLives);
+			break;
+		case SEQ_HURT:
+			PlaySound ("wav/hit_prince.wav");
+			stGame->iCurLives--;
+			if (stGame->iCurLives == 0) { Die(); break; }
+			Flash (0x00, 0x00, 0xaa);
+			SetTile (stGame->iSequenceCell, '_');
+			break;
+		case SEQ_LEVEL:
+			stGame->iCurLevel++;
+			LoadLevel (stGame->iCurLevel, stGame->iMaxLives);
+			break;
+		case SEQ_VICTORY:
+			stGame->iSteps = 0;
+			stGame->iCurLevel = 1;
+			LoadLevel (stGame->iCurLevel, START_LIVES);
+			break;
 	}
 
-	/*** refresh screen ***/
-	SDL_RenderPresent (ascreen);
+	PushHeld();
 }
 /*****************************************************************************/
-void PreventCPUEating (void)
+int HoldKey (SDL_Event *event)
 /*****************************************************************************/
 {
-	progspeed = REFRESH_PROG;
-	while ((SDL_GetTicks() - looptime) < progspeed)
+	/*** Returns 1 if the key must wait for the sequence to end. ***/
+
+	switch (event->key.keysym.sym)
 	{
-		SDL_Delay (10);
+		case SDLK_ESCAPE:
+		case SDLK_q:
+		case SDLK_F8:
+		case SDLK_F9:
+		case SDLK_BACKSPACE:
+			return (0);
 	}
-	looptime = SDL_GetTicks();
+	if (iNrHeld < MAX_HELD)
+	{
+		arHeld[iNrHeld] = *event;
+		iNrHeld++;
+	}
+
+	return (1);
 }
 /*****************************************************************************/
-void ExMarks (void)
+void PushHeld (void)
 /*****************************************************************************/
 {
-	int iX, iY;
+	/*** Used for looping. ***/
+	int iLoopHeld;
 
-	/*** Mode check. ***/
-	iX = 9;
-	switch (iMode)
+	/*** Hand the held keys back, unless something still waits. ***/
+	if ((stGame->iSequence != SEQ_NONE) || (iOverlay != OVL_NONE)) { return; }
+	for (iLoopHeld = 0; iLoopHeld < iNrHeld; iLoopHeld++)
+		{ SDL_PushEvent (&arHeld[iLoopHeld]); }
+	iNrHeld = 0;
+}
+/*****************************************************************************/
+void QueueMove (int iDir, int iKey, Uint32 iAt)
+/*****************************************************************************/
+{
+	/*** An arrow key, or with iDir 0 a mode key. A mode key waits only ***/
+	/*** behind moves, so that it is for the move after it. ***/
+
+	struct move *stMove;
+
+	if ((iDir == 0) && (iNrMoves == 0)) { ToggleMoveKey (iKey); return; }
+	if (iNrMoves == MAX_MOVES) { iMovesDropped++; return; }
+	stMove = &arMoves[(iMoveFirst + iNrMoves) % MAX_MOVES];
+	iNrMoves++;
+	stMove->iDir = iDir;
+	stMove->iKey = iKey;
+	stMove->iAt = iAt;
+}
+/*****************************************************************************/
+void ToggleMoveKey (int iKey)
+/*****************************************************************************/
+{
+	switch (iKey)
 	{
-		case 0: iY = 9; break;
-		case 1: iY = 28; break;
-		case 2: iY = 47; break;
-		case 3: iY = 66; break;
-		case 4: iY = 85; break;
-		default:
-			printf ("[ WARN ] Invalid iMode value: %i.\n", iMode);
-			iMode = 2; iY = 47; break; /*** Fallback. ***/
+		case MOVE_JUMP: ToggleJump(); break;
+		case MOVE_CAREFUL: ToggleCareful(); break;
+		case MOVE_RUNJUMP: ToggleRunJump(); break;
 	}
-	ShowImage (imgchkb, iX, iY, "imgchkb");
+}
+/*****************************************************************************/
+int PlayQueued (void)
+/*****************************************************************************/
+{
+	/*** Plays the oldest move, for this game tick. Returns 1 if there ***/
+	/*** was one. It waits while the prince falls, when a move would ***/
+	/*** do nothing. The mode is cleared by the move, once it is played. ***/
 
-	/*** Zoom check. ***/
-	iX = 9;
-	switch (iZoom)
+	struct move *stMove;
+
+	/*** Mode keys take no tick of their own. ***/
+	while ((iNrMoves != 0) && (arMoves[iMoveFirst].iDir == 0))
+	{
+		ToggleMoveKey (arMoves[iMoveFirst].iKey);
+		iMoveFirst = (iMoveFirst + 1) % MAX_MOVES;
+		iNrMoves--;
+	}
+	if ((iNrMoves == 0) || (stGame->iPrinceFall == 1) || (InFall() == 1))
+		{ return (0); }
+	stMove = &arMoves[iMoveFirst];
+	iMoveFirst = (iMoveFirst + 1) % MAX_MOVES;
+	iNrMoves--;
+
+	PlayMove (stMove->iDir);
+	if (stGame->iSequence == SEQ_NONE) { GameActions(); }
+	iMoveAt = stMove->iAt;
+	iMoveShown = 0;
+
+	return (1);
+}
+/*****************************************************************************/
+void MoveShown (void)
+/*****************************************************************************/
+{
+	/*** After ShowGame(): counts the latency of the move just played. ***/
+
+	Uint32 iMs;
+
+	if (iMoveShown == 1) { return; }
+	iMoveShown = 1;
+	iMs = SDL_GetTicks() - iMoveAt;
+	if (iMs > LATENCY_MS) { iMs = LATENCY_MS; }
+	arLatency[iMs]++;
+}
+/*****************************************************************************/
+void ShowLatency (void)
+/*****************************************************************************/
+{
+	Uint32 iNr, iSum;
+	int iMedian, iP95, iMax;
+
+	/*** Used for looping. ***/
+	int iLoopMs;
+
+	iNr = 0;
+	for (iLoopMs = 0; iLoopMs <= LATENCY_MS; iLoopMs++)
+		{ iNr+=arLatency[iLoopMs]; }
+	if (iNr == 0) { return; }
+
+	iSum = 0;
+	iMedian = -1;
+	iP95 = -1;
+	iMax = 0;
+	for (iLoopMs = 0; iLoopMs <= LATENCY_MS; iLoopMs++)
+	{
+		iSum+=arLatency[iLoopMs];
+		if ((iMedian == -1) && (iSum * 2 >= iNr)) { iMedian = iLoopMs; }
+		if ((iP95 == -1) && (iSum * 20 >= iNr * 19)) { iP95 = iLoopMs; }
+		if (arLatency[iLoopMs] != 0) { iMax = iLoopMs; }
+	}
+	printf ("[ INFO ] Played %lu moves; input-to-render: median %i ms, 95%%"
+		" %i ms, max %i%s ms; %i dropped.\n", (unsigned long)iNr, iMedian,
+		iP95, iMax, (iMax == LATENCY_MS) ? "+" : "", iMovesDropped);
+}
+/*****************************************************************************/
+void BossKey (void)
+/*****************************************************************************/
+{
+	iOverlay = OVL_BOSSKEY;
+	ShowGame();
+}
+/*****************************************************************************/
+void ShowBossKey (void)
+/*****************************************************************************/
+{
+	ShowImage (imgscreend, 0, 0, "imgscreend");
+	ShowImage (imgblack, 102, 8, "imgblack");
+
+	ShowText (1, "C:\\>", 0xaa, 0xaa, 0xaa, 0);
+	if ((SDL_GetTicks() / 500) % 2 == 0)
+	{
+		/*** _ ***/
+		ShowChar (16, 6, 0xaa, 0xaa, 0xaa,
+			102 + (4 * (arWidth[4] * 2)), 8, 4, 2, 0);
+	}
+
+	/*** refresh screen ***/
+	SDL_RenderPresent (ascreen);
+}
+/*****************************************************************************/
+void PreventCPUEating (void)
+/*****************************************************************************/
+{
+	progspeed = REFRESH_PROG;
+	while ((SDL_GetTicks() - looptime) < progspeed)
+	{
+		SDL_Delay (10);
+	}
+	looptime = SDL_GetTicks();
+}
+/*****************************************************************************/
+void ExMarks (void)
+/*****************************************************************************/
+{
+	int iX, iY;
+
+	/*** Mode check. ***/
+	iX = 9;
+	switch (iMode)
+	{
+		case 0: iY = 9; break;
+		case 1: iY = 28; break;
+		case 2: iY = 47; break;
+		case 3: iY = 66; break;
+		case 4: iY = 85; break;
+		default:
+			printf ("[ WARN ] Invalid iMode value: %i.\n", iMode);
+			iMode = 2; iY = 47; break; /*** Fallback. ***/
+	}
+	ShowImage (imgchkb, iX, iY, "imgchkb");
+
+	/*** Zoom check. ***/
+	iX = 9;
+	switch (iZoom)
 	{
 		case 1: iY = 126; break;
 		case 2: iY = 145; break;
@@ -4282,46 +5390,111 @@ void PlaySound (char *sFile)
 	SDL_UnlockAudio();
 }
 /*****************************************************************************/
+void Flash (int iR, int iG, int iB)
+/*****************************************************************************/
+{
+	stGame->iFlash = 10;
+	stGame->iFlashR = iR; stGame->iFlashG = iG; stGame->iFlashB = iB;
+}
+/*****************************************************************************/
 void DropLoose (int iRoom, int iTile)
 /*****************************************************************************/
 {
-	int iRoomC, iTileC;
-	int iCrashed;
-	char cChar;
+	int iCell;
 
+	/*** Used for looping. ***/
+	int iLoopLoose;
+
+	/*** The floor only starts to wobble; RunLooseFloors() does the rest. ***/
+	iCell = Cell (iRoom, iTile);
+	for (iLoopLoose = 1; iLoopLoose <= stGame->iNrLoose; iLoopLoose++)
+	{
+		if (stGame->arLooseCell[iLoopLoose] == iCell) { return; }
+	}
+	if (stGame->iNrLoose == MAX_LOOSE) { return; } /*** Will be retried. ***/
+	stGame->iNrLoose++;
+	stGame->arLooseCell[stGame->iNrLoose] = iCell;
+	stGame->arLoosePhase[stGame->iNrLoose] = 0;
+	stGame->iHash ^= ZobristLoose (iCell, 0);
 	PlaySound ("wav/loose_wobble_1.wav");
-	SDL_Delay (100);
-	PlaySound ("wav/loose_wobble_2.wav");
-	SDL_Delay (100);
-	PlaySound ("wav/loose_wobble_3.wav");
-	arTiles[iRoom][iTile] = '.';
-	iCrashed = 0;
-	iRoomC = iRoom; iTileC = iTile;
-	do {
-		if (iTileC <= 20)
+}
+/*****************************************************************************/
+int LooseAt (int iCell)
+/*****************************************************************************/
+{
+	/*** Returns 1 if a falling (not wobbling) loose floor is in iCell. ***/
+
+	/*** Used for looping. ***/
+	int iLoopLoose;
+
+	for (iLoopLoose = 1; iLoopLoose <= stGame->iNrLoose; iLoopLoose++)
+	{
+		if ((stGame->arLooseCell[iLoopLoose] == iCell) &&
+			(stGame->arLoosePhase[iLoopLoose] >= 2)) { return (1); }
+	}
+
+	return (0);
+}
+/*****************************************************************************/
+void RunLooseFloors (void)
+/*****************************************************************************/
+{
+	int iCell, iNext;
+	int iDone;
+	char cChar;
+
+	/*** Used for looping. ***/
+	int iLoopLoose;
+
+	iLoopLoose = 1;
+	while (iLoopLoose <= stGame->iNrLoose)
+	{
+		iCell = stGame->arLooseCell[iLoopLoose];
+		stGame->iHash ^= ZobristLoose (iCell, stGame->arLoosePhase[iLoopLoose]);
+		stGame->arLoosePhase[iLoopLoose]++;
+		iDone = 0;
+		switch (stGame->arLoosePhase[iLoopLoose])
 		{
-			iTileC+=10;
-		} else if (arLinksD[iRoomC] != 0) {
-			iRoomC = arLinksD[iRoomC];
-			iTileC-=20;
+			case 1: PlaySound ("wav/loose_wobble_2.wav"); break;
+			case 2:
+				PlaySound ("wav/loose_wobble_3.wav");
+				SetTile (iCell, '.');
+				break;
+			default:
+				/*** One row down per tick, through the ghost row below. ***/
+				iNext = stGame->arReal[iCell + ROOM_W];
+				if (iNext == 0)
+				{
+					iDone = 1; /*** No room below; it falls out of the level. ***/
+				} else if (IsEmpty (stGame->arTile[iNext]) == 0) {
+					PlaySound ("wav/loose_crash.wav");
+					iDone = 1;
+					cChar = stGame->arTile[iNext];
+					if ((TileFlags (cChar) & TILE_BUTTON) != 0)
+					{
+						PushButton (cChar, 1);
+						SetTile (iNext, '-');
+					}
+					if (cChar == '_')
+						{ SetTile (iNext, '-'); }
+				} else {
+					stGame->arLooseCell[iLoopLoose] = iNext;
+				}
+				break;
 		}
-		if (IsEmpty (arTiles[iRoomC][iTileC]) == 0)
+		if (iDone == 1)
 		{
-			SDL_Delay (100);
-			PlaySound ("wav/loose_crash.wav");
-			iCrashed = 1;
-			cChar = arTiles[iRoomC][iTileC];
-			if (((cChar >= 'A') && (cChar <= 'R')) ||
-				((cChar >= 'a') && (cChar <= 'r')))
-			{
-				PushButton (cChar, 1);
-				arTiles[iRoomC][iTileC] = '-';
-			}
-			if (cChar == '_')
-				{ arTiles[iRoomC][iTileC] = '-'; }
+			/*** The last one takes its place. ***/
+			stGame->arLooseCell[iLoopLoose] = stGame->arLooseCell[stGame->iNrLoose];
+			stGame->arLoosePhase[iLoopLoose] =
+				stGame->arLoosePhase[stGame->iNrLoose];
+			stGame->iNrLoose--;
+		} else {
+			stGame->iHash ^= ZobristLoose (stGame->arLooseCell[iLoopLoose],
+				stGame->arLoosePhase[iLoopLoose]);
+			iLoopLoose++;
 		}
-	} while (iCrashed == 0);
-	SDL_Delay (100);
+	}
 }
 /*****************************************************************************/
 void GetOptionValue (char *sArgv, char *sValue)
@@ -4595,24 +5768,24 @@ void ShowText (int iLine, char *sText, int iR, int iG, int iB, int iInGame)
 void MovingStarts (void)
 /*****************************************************************************/
 {
-	iSteps++;
-	if (iPrinceSword == 2) { iPrinceSword = 1; }
-	switch (iPrinceHang)
+	stGame->iSteps++;
+	if (stGame->iPrinceSword == 2) { stGame->iPrinceSword = 1; }
+	switch (stGame->iPrinceHang)
 	{
-		case 2: iPrinceHang = 1; break;
-		default: iPrinceHang = 0; break;
+		case 2: stGame->iPrinceHang = 1; break;
+		default: stGame->iPrinceHang = 0; break;
 	}
-	iShowStepsCoins = 0;
-	iNoMessage = 0;
+	stGame->iShowStepsCoins = 0;
+	stGame->iNoMessage = 0;
 }
 /*****************************************************************************/
 void MovingEnds (void)
 /*****************************************************************************/
 {
-	if (iCareful == 0) { iPrinceSafe = 0; }
-	iJump = 0;
-	iCareful = 0;
-	iRunJump = 0;
+	if (stGame->iCareful == 0) { stGame->iPrinceSafe = 0; }
+	stGame->iJump = 0;
+	stGame->iCareful = 0;
+	stGame->iRunJump = 0;
 }
 /*****************************************************************************/
 int GetX (int iTile)
@@ -4655,31 +5828,62 @@ int GetY (int iTile)
 	return (iY);
 }
 /*****************************************************************************/
-void Teleport (char cGoTo)
+void BuildTeleports (int iLevel)
 /*****************************************************************************/
 {
+	int iCell;
+	char cTile;
+
 	/*** Used for looping. ***/
 	int iLoopRoom;
 	int iLoopTile;
+	int iLoopChar;
 
+	memset (stGame->arTeleport, 0, sizeof (stGame->arTeleport));
 	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
 	{
 		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
 		{
-			if ((arTiles[iLoopRoom][iLoopTile] == cGoTo) &&
-				((iLoopRoom != iCurRoom) || (iLoopTile != iPrinceTile)) &&
-				((iLoopRoom != GetRoomLeft (iCurRoom, iPrinceTile)) ||
-				(iLoopTile != GetTileLeft (iCurRoom, iPrinceTile))))
+			iCell = Cell (iLoopRoom, iLoopTile);
+			cTile = stGame->arTile[iCell];
+			if (((TileFlags (cTile) & TILE_TELEPORT) == 0) || (cTile == ','))
+				{ continue; }
+			if (stGame->arTeleport[(unsigned char)cTile][0] == 0)
 			{
-				iCurRoom = iLoopRoom;
-				iPrinceTile = iLoopTile;
-				PlaySound ("wav/mirror.wav");
-				return;
+				stGame->arTeleport[(unsigned char)cTile][0] = iCell;
+			} else if (stGame->arTeleport[(unsigned char)cTile][1] == 0) {
+				stGame->arTeleport[(unsigned char)cTile][1] = iCell;
 			}
 		}
 	}
 
-	printf ("[ WARN ] No similar teleport ('%c') found.\n", cGoTo);
+	for (iLoopChar = 0; iLoopChar <= 255; iLoopChar++)
+	{
+		if ((stGame->arTeleport[iLoopChar][0] != 0) &&
+			(stGame->arTeleport[iLoopChar][1] == 0))
+		{
+			printf ("[ WARN ] Level %i: no similar teleport for '%c' (room %i).\n",
+				iLevel, iLoopChar, stGame->arTeleport[iLoopChar][0] / ROOM_CELLS);
+		}
+	}
+}
+/*****************************************************************************/
+void Teleport (char cGoTo)
+/*****************************************************************************/
+{
+	int iFrom, iTo;
+
+	/*** The prince is on the letter, or right of it. ***/
+	iFrom = PrinceCell();
+	if (stGame->arTile[iFrom] == ',') { iFrom = stGame->arReal[iFrom - 1]; }
+
+	iTo = stGame->arTeleport[(unsigned char)cGoTo][0];
+	if (iTo == iFrom) { iTo = stGame->arTeleport[(unsigned char)cGoTo][1]; }
+	if (iTo == 0) { return; } /*** Reported by BuildTeleports(). ***/
+
+	stGame->iCurRoom = iTo / ROOM_CELLS;
+	stGame->iPrinceTile = arCellTile[iTo % ROOM_CELLS];
+	PlaySound ("wav/mirror.wav");
 }
 /*****************************************************************************/
 void DebugRoom (int iRoom)
@@ -4687,138 +5891,77 @@ void DebugRoom (int iRoom)
 {
 	/*** Currently unused. ***/
 
+	int iCell;
+
+	/*** Used for looping. ***/
+	int iLoopRow;
+	int iLoopCol;
+
 	printf ("--------------------------------\n");
-	printf ("%c%c%c%c%c%c%c%c%c%c %c%c%c%c%c%c%c%c%c%c %i%i%i%i%i%i%i%i%i%i\n",
-		arTiles[iRoom][1], arTiles[iRoom][2], arTiles[iRoom][3],
-		arTiles[iRoom][4], arTiles[iRoom][5], arTiles[iRoom][6],
-		arTiles[iRoom][7], arTiles[iRoom][8], arTiles[iRoom][9],
-		arTiles[iRoom][10], arMobBck[iRoom][1], arMobBck[iRoom][2],
-		arMobBck[iRoom][3], arMobBck[iRoom][4], arMobBck[iRoom][5],
-		arMobBck[iRoom][6], arMobBck[iRoom][7], arMobBck[iRoom][8],
-		arMobBck[iRoom][9], arMobBck[iRoom][10], arMobDir[iRoom][1],
-		arMobDir[iRoom][2], arMobDir[iRoom][3], arMobDir[iRoom][4],
-		arMobDir[iRoom][5], arMobDir[iRoom][6], arMobDir[iRoom][7],
-		arMobDir[iRoom][8], arMobDir[iRoom][9], arMobDir[iRoom][10]);
-	printf ("%c%c%c%c%c%c%c%c%c%c %c%c%c%c%c%c%c%c%c%c %i%i%i%i%i%i%i%i%i%i\n",
-		arTiles[iRoom][11], arTiles[iRoom][12], arTiles[iRoom][13],
-		arTiles[iRoom][14], arTiles[iRoom][15], arTiles[iRoom][16],
-		arTiles[iRoom][17], arTiles[iRoom][18], arTiles[iRoom][19],
-		arTiles[iRoom][20], arMobBck[iRoom][11], arMobBck[iRoom][12],
-		arMobBck[iRoom][13], arMobBck[iRoom][14], arMobBck[iRoom][15],
-		arMobBck[iRoom][16], arMobBck[iRoom][17], arMobBck[iRoom][18],
-		arMobBck[iRoom][19], arMobBck[iRoom][20], arMobDir[iRoom][11],
-		arMobDir[iRoom][12], arMobDir[iRoom][13], arMobDir[iRoom][14],
-		arMobDir[iRoom][15], arMobDir[iRoom][16], arMobDir[iRoom][17],
-		arMobDir[iRoom][18], arMobDir[iRoom][19], arMobDir[iRoom][20]);
-	printf ("%c%c%c%c%c%c%c%c%c%c %c%c%c%c%c%c%c%c%c%c %i%i%i%i%i%i%i%i%i%i\n",
-		arTiles[iRoom][21], arTiles[iRoom][22], arTiles[iRoom][23],
-		arTiles[iRoom][24], arTiles[iRoom][25], arTiles[iRoom][26],
-		arTiles[iRoom][27], arTiles[iRoom][28], arTiles[iRoom][29],
-		arTiles[iRoom][30], arMobBck[iRoom][21], arMobBck[iRoom][22],
-		arMobBck[iRoom][23], arMobBck[iRoom][24], arMobBck[iRoom][25],
-		arMobBck[iRoom][26], arMobBck[iRoom][27], arMobBck[iRoom][28],
-		arMobBck[iRoom][29], arMobBck[iRoom][30], arMobDir[iRoom][21],
-		arMobDir[iRoom][22], arMobDir[iRoom][23], arMobDir[iRoom][24],
-		arMobDir[iRoom][25], arMobDir[iRoom][26], arMobDir[iRoom][27],
-		arMobDir[iRoom][28], arMobDir[iRoom][29], arMobDir[iRoom][30]);
+	for (iLoopRow = 0; iLoopRow <= 2; iLoopRow++)
+	{
+		iCell = Cell (iRoom, (iLoopRow * 10) + 1);
+		for (iLoopCol = 0; iLoopCol <= 9; iLoopCol++)
+			{ printf ("%c", stGame->arTile[iCell + iLoopCol]); }
+		printf (" ");
+		for (iLoopCol = 0; iLoopCol <= 9; iLoopCol++)
+			{ printf ("%c", stGame->arMobBck[iCell + iLoopCol]); }
+		printf (" ");
+		for (iLoopCol = 0; iLoopCol <= 9; iLoopCol++)
+			{ printf ("%i", stGame->arMobDir[iCell + iLoopCol]); }
+		printf ("\n");
+	}
 	printf ("--------------------------------\n");
 }
 /*****************************************************************************/
 void ViewSign (int iLevel, int iRoom, int iTile)
 /*****************************************************************************/
 {
-	int iWarn;
-	SDL_Texture *imgsign;
 	int iWidth, iHeight;
-	/***/
-	int iOldMode, iOldZoom;
-	int iViewSign;
-	SDL_Event event;
 
 	snprintf (sSignPathFile, MAX_PATHFILE, "%s%s%s%ssign_%i_%i_%i.png",
 		DIR_GAMES, SLASH, arGames[iGameSel], SLASH, iLevel, iRoom, iTile);
-	iWarn = 0; imgsign = NULL;
+	iSignWarn = 0; imgsign = NULL;
 	if (access (sSignPathFile, R_OK) == -1)
 	{
-		iWarn = 1;
+		iSignWarn = 1;
 	} else {
 		imgsign = IMG_LoadTexture (ascreen, sSignPathFile);
 		if (imgsign == NULL)
 		{
-			iWarn = 2;
+			iSignWarn = 2;
 		} else {
 			SDL_QueryTexture (imgsign, NULL, NULL, &iWidth, &iHeight);
 			if ((iWidth != 819) || (iHeight != 560))
 			{
-				iWarn = 3;
+				iSignWarn = 3;
 				SDL_DestroyTexture (imgsign);
 			}
 		}
 	}
 
 	/*** Make sure transparent PNG visuals are the same for all players. ***/
-	iOldMode = iMode;
+	/*** ShowGame() draws the level like this, under the sign. ***/
+	iSignMode = iMode;
 	iMode = 2;
-	iOldZoom = iZoom;
+	iSignZoom = iZoom;
 	iZoom = 7;
-	ShowGame();
-	SDL_Delay (100); /*** TODO: No idea why this is necessary... ***/
-
-	iViewSign = 1;
-
-	ShowViewSign (imgsign, iWarn);
-	while (iViewSign == 1)
-	{
-		while (SDL_PollEvent (&event))
-		{
-			switch (event.type)
-			{
-				case SDL_KEYDOWN:
-					switch (event.key.keysym.sym)
-					{
-						case SDLK_ESCAPE:
-						case SDLK_KP_ENTER:
-						case SDLK_RETURN:
-						case SDLK_SPACE:
-						case SDLK_q:
-						case SDLK_v:
-							iViewSign = 0;
-							break;
-					}
-					break;
-				case SDL_WINDOWEVENT:
-					if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
-						{ ShowGame(); ShowViewSign (imgsign, iWarn); } break;
-				case SDL_QUIT:
-					Quit(); break;
-			}
-		}
-
-		PreventCPUEating();
-	}
-
-	iMode = iOldMode;
-	iZoom = iOldZoom;
-
-	if (iWarn == 0)
-	{
-		SDL_DestroyTexture (imgsign);
-	}
 
+	iOverlay = OVL_SIGN;
 	ShowGame();
 }
 /*****************************************************************************/
-void ShowViewSign (SDL_Texture *imgsign, int iWarn)
+void ShowViewSign (void)
 /*****************************************************************************/
 {
 	ShowImage (imgscreend, 0, 0, "imgscreend");
 
-	if (iWarn == 0)
+	if (iSignWarn == 0)
 	{
 		ShowImage (imgsign, 102, 8, "imgsign");
 	} else {
 		ShowImage (imgblack, 102, 8, "imgblack");
-		switch (iWarn)
+		switch (iSignWarn)
 		{
 			case 1: ShowText (1, "Sign image not found:",
 				0xaa, 0xaa, 0xaa, 0); break;
@@ -4834,3 +5977,2015 @@ void ShowViewSign (SDL_Texture *imgsign, int iWarn)
 	SDL_RenderPresent (ascreen);
 }
 /*****************************************************************************/
+/*****************************************************************************/
+void AddPlatform (int iRoom, int iTile)
+/*****************************************************************************/
+{
+	if (stGame->iNrPlatforms == MAX_PLATFORMS)
+	{
+		printf ("[ WARN ] Too many moving platforms.\n");
+		return;
+	}
+	stGame->iNrPlatforms++;
+	stGame->arPlatformRoom[stGame->iNrPlatforms] = iRoom;
+	stGame->arPlatformTile[stGame->iNrPlatforms] = iTile;
+}
+/*****************************************************************************/
+void MovePlatform (int iPlatform)
+/*****************************************************************************/
+{
+	int iRoom, iTile;
+	int iCell, iNextCell;
+	int iDir;
+	char cPlatform;
+	char cNext;
+	int iNextRoom, iNextTile;
+
+	iRoom = stGame->arPlatformRoom[iPlatform];
+	iTile = stGame->arPlatformTile[iPlatform];
+	iCell = Cell (iRoom, iTile);
+	cPlatform = stGame->arTile[iCell];
+	if ((cPlatform != '<') && (cPlatform != '>')) { return; }
+
+	/*** The arMobDir values match TO_LEFT, TO_RIGHT, TO_UP and TO_DOWN. ***/
+	iDir = stGame->arMobDir[iCell];
+	cNext = stGame->arTile[iCell + arDirOffset[iDir]];
+	if ((cNext == '.') || (cNext == '`'))
+	{
+		iNextCell = stGame->arReal[iCell + arDirOffset[iDir]];
+		iNextRoom = iNextCell / ROOM_CELLS;
+		iNextTile = arCellTile[iNextCell % ROOM_CELLS];
+		stGame->arMobBck[iNextCell] = cNext;
+		stGame->arMobDir[iNextCell] = iDir;
+		SetTile (iCell, stGame->arMobBck[iCell]);
+		SetTile (iNextCell, cPlatform);
+		if ((iRoom == stGame->iCurRoom) && (iTile == stGame->iPrinceTile))
+		{
+			stGame->iCurRoom = iNextRoom;
+			stGame->iPrinceTile = iNextTile;
+		}
+		stGame->arPlatformRoom[iPlatform] = iNextRoom;
+		stGame->arPlatformTile[iPlatform] = iNextTile;
+	} else {
+		switch (iDir)
+		{
+			case TO_LEFT: stGame->arMobDir[iCell] = TO_RIGHT; break;
+			case TO_RIGHT: stGame->arMobDir[iCell] = TO_LEFT; break;
+			case TO_UP: stGame->arMobDir[iCell] = TO_DOWN; break;
+			case TO_DOWN: stGame->arMobDir[iCell] = TO_UP; break;
+		}
+	}
+}
+/*****************************************************************************/
+void StartGateTimer (int iRoom, int iTile, int iFrames)
+/*****************************************************************************/
+{
+	int iGate;
+
+	iGate = stGame->arGate[Cell (iRoom, iTile)];
+	if (iGate == 0) { return; }
+	if (stGame->arWheelSlot[iGate] != 0)
+	{
+		UnscheduleGate (iGate);
+		stGame->iHash ^= ZobristGate (iGate, stGame->arGateExpiry[iGate]);
+	}
+	stGame->arGateExpiry[iGate] = stGame->iGameTick + iFrames;
+	stGame->iHash ^= ZobristGate (iGate, stGame->arGateExpiry[iGate]);
+	ScheduleGate (iGate);
+}
+/*****************************************************************************/
+void ScheduleGate (int iGate)
+/*****************************************************************************/
+{
+	Uint16 iExpiry, iDelta;
+	int iLevel, iSlot;
+
+	iExpiry = stGame->arGateExpiry[iGate];
+	iDelta = iExpiry - stGame->iGameTick;
+
+	/*** The level depends on how far away, the slot on when exactly. ***/
+	iLevel = 0;
+	while ((iLevel < WHEEL_LEVELS - 1) &&
+		(iDelta >= (1 << (WHEEL_BITS * (iLevel + 1)))))
+		{ iLevel++; }
+	iSlot = (iExpiry >> (WHEEL_BITS * iLevel)) & (WHEEL_SLOTS - 1);
+
+	stGame->arWheelSlot[iGate] = (iLevel * WHEEL_SLOTS) + iSlot + 1;
+	stGame->arWheelPrev[iGate] = 0;
+	stGame->arWheelNext[iGate] = stGame->arWheel[iLevel][iSlot];
+	if (stGame->arWheel[iLevel][iSlot] != 0)
+		{ stGame->arWheelPrev[stGame->arWheel[iLevel][iSlot]] = iGate; }
+	stGame->arWheel[iLevel][iSlot] = iGate;
+}
+/*****************************************************************************/
+void UnscheduleGate (int iGate)
+/*****************************************************************************/
+{
+	int iLevel, iSlot;
+
+	iLevel = (stGame->arWheelSlot[iGate] - 1) / WHEEL_SLOTS;
+	iSlot = (stGame->arWheelSlot[iGate] - 1) % WHEEL_SLOTS;
+	if (stGame->arWheelPrev[iGate] != 0)
+	{
+		stGame->arWheelNext[stGame->arWheelPrev[iGate]] =
+			stGame->arWheelNext[iGate];
+	} else {
+		stGame->arWheel[iLevel][iSlot] = stGame->arWheelNext[iGate];
+	}
+	if (stGame->arWheelNext[iGate] != 0)
+	{
+		stGame->arWheelPrev[stGame->arWheelNext[iGate]] =
+			stGame->arWheelPrev[iGate];
+	}
+	stGame->arWheelSlot[iGate] = 0;
+}
+/*****************************************************************************/
+void RunGateTimers (void)
+/*****************************************************************************/
+{
+	int iCell;
+	int iGate, iNext;
+	int iSlot;
+
+	/*** Used for looping. ***/
+	int iLoopLevel;
+
+	stGame->iGameTick++;
+
+	/*** Move timers down from the higher levels, once per turn below. ***/
+	for (iLoopLevel = WHEEL_LEVELS - 1; iLoopLevel >= 1; iLoopLevel--)
+	{
+		if ((stGame->iGameTick & ((1 << (WHEEL_BITS * iLoopLevel)) - 1)) != 0)
+			{ continue; }
+		iSlot = (stGame->iGameTick >> (WHEEL_BITS * iLoopLevel)) &
+			(WHEEL_SLOTS - 1);
+		iGate = stGame->arWheel[iLoopLevel][iSlot];
+		stGame->arWheel[iLoopLevel][iSlot] = 0;
+		while (iGate != 0)
+		{
+			iNext = stGame->arWheelNext[iGate];
+			ScheduleGate (iGate);
+			iGate = iNext;
+		}
+	}
+
+	/*** Everything in the current slot expires now. ***/
+	iSlot = stGame->iGameTick & (WHEEL_SLOTS - 1);
+	iGate = stGame->arWheel[0][iSlot];
+	stGame->arWheel[0][iSlot] = 0;
+	while (iGate != 0)
+	{
+		iNext = stGame->arWheelNext[iGate];
+		stGame->arWheelSlot[iGate] = 0;
+		stGame->iHash ^= ZobristGate (iGate, stGame->arGateExpiry[iGate]);
+		iCell = stGame->arGateCell[iGate];
+		if (stGame->arTile[iCell] == '"')
+		{
+			SetTile (iCell, ')');
+			if (iCell / ROOM_CELLS == stGame->iCurRoom)
+			{
+				PlaySound ("wav/gate_close_fast.wav");
+			}
+		}
+		iGate = iNext;
+	}
+}
+/*****************************************************************************/
+void InitZobrist (void)
+/*****************************************************************************/
+{
+	Uint64 iSeed;
+
+	/*** Used for looping. ***/
+	int iLoopCell;
+
+	/*** Always the same keys, so that hashes can be compared between runs. ***/
+	iSeed = 0x50756e79ULL;
+	for (iLoopCell = 0; iLoopCell < CELLS; iLoopCell++)
+	{
+		iSeed+=0x9e3779b97f4a7c15ULL;
+		arZobrist[iLoopCell] = Mix64 (iSeed);
+	}
+}
+/*****************************************************************************/
+Uint64 Mix64 (Uint64 iValue)
+/*****************************************************************************/
+{
+	/*** The splitmix64 finalizer. ***/
+
+	iValue = (iValue ^ (iValue >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	iValue = (iValue ^ (iValue >> 27)) * 0x94d049bb133111ebULL;
+
+	return (iValue ^ (iValue >> 31));
+}
+/*****************************************************************************/
+Uint64 ZobristTile (int iCell, char cChar)
+/*****************************************************************************/
+{
+	return (Mix64 (arZobrist[iCell] ^ (Uint8)cChar));
+}
+/*****************************************************************************/
+Uint64 ZobristGate (int iGate, Uint16 iExpiry)
+/*****************************************************************************/
+{
+	return (Mix64 (arZobrist[stGame->arGateCell[iGate]] +
+		((Uint64)(iExpiry + 1) << 32)));
+}
+/*****************************************************************************/
+Uint64 ZobristGuard (int iGuard)
+/*****************************************************************************/
+{
+	return (Mix64 (((Uint64)5 << 56) + ((Uint64)iGuard << 40) +
+		((Uint64)stGame->arGuardRoom[iGuard] << 24) +
+		(stGame->arGuardLoc[iGuard] << 16) + (stGame->arGuardType[iGuard] << 8) +
+		stGame->arGuardHP[iGuard]));
+}
+/*****************************************************************************/
+Uint64 ZobristFlag (int iFlag, int iValue)
+/*****************************************************************************/
+{
+	return (Mix64 (((Uint64)6 << 56) + ((Uint64)iFlag << 32) + (Uint32)iValue));
+}
+/*****************************************************************************/
+Uint64 ZobristLoose (int iCell, int iPhase)
+/*****************************************************************************/
+{
+	/*** By cell, not slot; RunLooseFloors() moves them around. ***/
+
+	return (Mix64 (((Uint64)7 << 56) + ((Uint64)iCell << 16) + iPhase));
+}
+/*****************************************************************************/
+Uint64 HashFull (void)
+/*****************************************************************************/
+{
+	/*** What iHash should be, computed from scratch. ***/
+
+	Uint64 iHash;
+	int iCell;
+
+	/*** Used for looping. ***/
+	int iLoopRoom;
+	int iLoopTile;
+	int iLoopGate;
+	int iLoopGuard;
+	int iLoopFlag;
+	int iLoopLoose;
+
+	iHash = 0;
+	for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+	{
+		for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+		{
+			iCell = Cell (iLoopRoom, iLoopTile);
+			iHash ^= ZobristTile (iCell, stGame->arTile[iCell]);
+		}
+	}
+	for (iLoopGate = 1; iLoopGate <= stGame->iNrGates; iLoopGate++)
+	{
+		if (stGame->arWheelSlot[iLoopGate] != 0)
+		{
+			iHash ^= ZobristGate (iLoopGate,
+				stGame->arGateExpiry[iLoopGate]);
+		}
+	}
+	for (iLoopGuard = 0; iLoopGuard < stGame->iNrGuards; iLoopGuard++)
+		{ iHash ^= ZobristGuard (iLoopGuard); }
+	for (iLoopFlag = 0; iLoopFlag < TRIG_FLAGS; iLoopFlag++)
+		{ iHash ^= ZobristFlag (iLoopFlag, stGame->arFlag[iLoopFlag]); }
+	for (iLoopLoose = 1; iLoopLoose <= stGame->iNrLoose; iLoopLoose++)
+	{
+		iHash ^= ZobristLoose (stGame->arLooseCell[iLoopLoose],
+			stGame->arLoosePhase[iLoopLoose]);
+	}
+
+	return (iHash);
+}
+/*****************************************************************************/
+Uint64 HashFields (void)
+/*****************************************************************************/
+{
+	/*** iHash, which follows the tiles, gate timers, guards, flags and ***/
+	/*** loose floors, with the prince mixed in but for his lives. ***/
+
+	int arValue[16];
+	int iNrValues;
+	Uint64 iHash;
+
+	/*** Used for looping. ***/
+	int iLoopValue;
+
+	iNrValues = 0;
+	arValue[iNrValues++] = stGame->iCurLevel;
+	arValue[iNrValues++] = stGame->iCurRoom;
+	arValue[iNrValues++] = stGame->iPrinceTile;
+	arValue[iNrValues++] = stGame->iPrinceDir;
+	arValue[iNrValues++] = stGame->iPrinceHang;
+	arValue[iNrValues++] = stGame->iPrinceFall;
+	arValue[iNrValues++] = stGame->iPrinceSword;
+	arValue[iNrValues++] = stGame->iPrinceFloat;
+	arValue[iNrValues++] = stGame->iMaxLives;
+	arValue[iNrValues++] = stGame->iPrinceCoins;
+	arValue[iNrValues++] = stGame->iJump;
+	arValue[iNrValues++] = stGame->iCareful;
+	arValue[iNrValues++] = stGame->iRunJump;
+	arValue[iNrValues++] = stGame->iSequence;
+	arValue[iNrValues++] = stGame->iNrLoose;
+	arValue[iNrValues++] = stGame->iNrGuards;
+
+	iHash = stGame->iHash;
+	for (iLoopValue = 0; iLoopValue < iNrValues; iLoopValue++)
+	{
+		iHash ^= Mix64 (((Uint64)(iLoopValue + 1) << 32) ^
+			(Uint32)arValue[iLoopValue]);
+	}
+
+	return (iHash);
+}
+/*****************************************************************************/
+Uint64 HashGame (void)
+/*****************************************************************************/
+{
+	/*** The state hash: HashFields(), plus the lives and timer phases. ***/
+
+	return (HashFields() ^ Mix64 (((Uint64)3 << 48) + stGame->iCurLives) ^
+		Mix64 (((Uint64)2 << 48) + (stGame->iMobMove << 1) +
+		((stGame->iPlayTicks * REFRESH_GAME / 1000) % 2)));
+}
+/*****************************************************************************/
+void CheckHash (void)
+/*****************************************************************************/
+{
+	/*** For --debughash, once per game tick. ***/
+
+	Uint64 iFull;
+
+	iFull = HashFull();
+	if (stGame->iHash != iFull)
+	{
+		printf ("[ WARN ] Level %i, tick %lu: state hash %016llx, but"
+			" recomputed %016llx!\n", stGame->iCurLevel,
+			(unsigned long)stGame->iPlayTicks,
+			(unsigned long long)stGame->iHash, (unsigned long long)iFull);
+		stGame->iHash = iFull;
+	}
+}
+/*****************************************************************************/
+Uint64 CompareSwap (Uint64 *iWhere, Uint64 iOld, Uint64 iNew)
+/*****************************************************************************/
+{
+	/*** Returns what was there; iNew is stored only if that was iOld. ***/
+
+	Uint64 iWas;
+
+#ifdef ATOMIC_CAS64
+	iWas = __sync_val_compare_and_swap (iWhere, iOld, iNew);
+#else
+	SDL_AtomicLock (&iSolveLock);
+	iWas = *iWhere;
+	if (iWas == iOld) { *iWhere = iNew; }
+	SDL_AtomicUnlock (&iSolveLock);
+#endif
+
+	return (iWas);
+}
+/*****************************************************************************/
+int SeenState (Uint64 iKey, Uint64 iLeft)
+/*****************************************************************************/
+{
+	/*** Returns 1 if iKey is in arSolveSeen, with a value that covers ***/
+	/*** iLeft; see LeftCovers(). If not, iLeft is added to its values, ***/
+	/*** which do not cover each other. ***/
+
+	Uint64 iWas, iFirst;
+	Uint32 iSlot;
+	int iNew;
+
+	if (iKey == 0) { iKey = 1; }
+	iSlot = (Uint32)iKey & (SOLVE_TABLE - 1);
+	for (;;)
+	{
+		iWas = CompareSwap (&arSolveSeen[iSlot], 0, iKey);
+		if ((iWas == 0) || (iWas == iKey)) { break; }
+		iSlot = (iSlot + 1) & (SOLVE_TABLE - 1);
+	}
+	if (KnownLeft (iSlot, iLeft) == 1) { return (1); }
+
+	/*** Full only past the states cap, which then stops the search. ***/
+	iNew = SDL_AtomicAdd (&stSolveLefts, 1) + 1;
+	if (iNew >= SOLVE_TABLE) { return (1); }
+	arSolveLeft[iNew] = iLeft;
+	do {
+		iFirst = CompareSwap (&arSolveFirst[iSlot], 0, 0);
+		arSolveNext[iNew] = (Uint32)iFirst;
+	} while (CompareSwap (&arSolveFirst[iSlot], iFirst, iNew) != iFirst);
+
+	return (0);
+}
+/*****************************************************************************/
+int KnownLeft (Uint32 iSlot, Uint64 iLeft)
+/*****************************************************************************/
+{
+	/*** Returns 1 if a value of arSolveSeen[iSlot] covers iLeft. ***/
+
+	Uint32 iValue;
+
+	iValue = (Uint32)CompareSwap (&arSolveFirst[iSlot], 0, 0);
+	while (iValue != 0)
+	{
+		if (LeftCovers (arSolveLeft[iValue], iLeft) == 1) { return (1); }
+		iValue = arSolveNext[iValue];
+	}
+
+	return (0);
+}
+/*****************************************************************************/
+int LeftCovers (Uint64 iLeft, Uint64 iThan)
+/*****************************************************************************/
+{
+	/*** A value holds the ticks the gates have left (see StateKey()) and, ***/
+	/*** from SOLVE_TAG on, 0 if the state can be had at any phase, else ***/
+	/*** 1 + the phase it is at. Waiting for later phases then costs gate ***/
+	/*** time. An open gate is never worse than a closed one, nor are more ***/
+	/*** lives worse, so returns 1 if iLeft has at least as many lives, and ***/
+	/*** as much time at every phase of iThan. ***/
+
+	int iPhase, iThanPhase;
+	int iWait;
+	int iTicks, iThanTicks;
+
+	/*** Used for looping. ***/
+	int iLoopGate;
+
+	if ((iLeft >> SOLVE_LIVES) < (iThan >> SOLVE_LIVES)) { return (0); }
+	iPhase = (int)(iLeft >> SOLVE_TAG) & 0xff;
+	iThanPhase = (int)(iThan >> SOLVE_TAG) & 0xff;
+	if (iPhase == 0)
+	{
+		iWait = 0;
+	} else if (iThanPhase == 0) {
+		iWait = SOLVE_PHASES - 1;
+	} else {
+		iWait = (iThanPhase - iPhase + SOLVE_PHASES) % SOLVE_PHASES;
+	}
+	for (iLoopGate = 0; iLoopGate < SOLVE_LEFT; iLoopGate++)
+	{
+		iTicks = (iLeft >> (16 * iLoopGate)) & 0xffff;
+		iThanTicks = (iThan >> (16 * iLoopGate)) & 0xffff;
+		if (iThanTicks == 0) { continue; } /*** Not running. ***/
+		if (iTicks < iThanTicks + iWait) { return (0); }
+	}
+
+	return (1);
+}
+/*****************************************************************************/
+Uint64 StateKey (Uint64 *iLeft)
+/*****************************************************************************/
+{
+	/*** HashGame(), exact for the solver but for the clock, which is in ***/
+	/*** PhaseKey(), and the ticks the running gates have left, which go ***/
+	/*** to *iLeft, 16 bits each, with the lives from SOLVE_LIVES on; see ***/
+	/*** LeftCovers(). Gates opened together share their 16 bits, and the ***/
+	/*** key says which share. If the gates run to more than SOLVE_LEFT ***/
+	/*** different ticks, these are in the key instead. Two states with ***/
+	/*** the same key, phase and *iLeft act the same. ***/
+
+	Uint64 iKey;
+	Uint16 arTicks[MAX_GATES + 1];
+	Uint16 arLane[SOLVE_LEFT];
+	int iNrLanes;
+	int arValue[2];
+	int iCell;
+
+	/*** Used for looping. ***/
+	int iLoopGate;
+	int iLoopLane;
+	int iLoopGuard;
+	int iLoopPlatform;
+	int iLoopValue;
+
+	iKey = HashFields();
+	*iLeft = 0;
+	iNrLanes = 0;
+	for (iLoopGate = 1; iLoopGate <= stGame->iNrGates; iLoopGate++)
+	{
+		if (stGame->arWheelSlot[iLoopGate] == 0) { continue; }
+		iKey ^= ZobristGate (iLoopGate, stGame->arGateExpiry[iLoopGate]);
+		arTicks[iLoopGate] = stGame->arGateExpiry[iLoopGate] -
+			stGame->iGameTick;
+		if (iNrLanes == -1) { continue; }
+		for (iLoopLane = 0; iLoopLane < iNrLanes; iLoopLane++)
+			{ if (arLane[iLoopLane] == arTicks[iLoopGate]) { break; } }
+		if (iLoopLane == SOLVE_LEFT) { iNrLanes = -1; continue; }
+		if (iLoopLane == iNrLanes) { arLane[iNrLanes++] = arTicks[iLoopGate]; }
+	}
+	for (iLoopGate = 1; iLoopGate <= stGame->iNrGates; iLoopGate++)
+	{
+		if (stGame->arWheelSlot[iLoopGate] == 0) { continue; }
+		if (iNrLanes == -1)
+		{
+			iKey ^= ZobristGate (iLoopGate, arTicks[iLoopGate]);
+			continue;
+		}
+		for (iLoopLane = 0; arLane[iLoopLane] != arTicks[iLoopGate];
+			iLoopLane++) {}
+		iKey ^= Mix64 (((Uint64)13 << 56) + ((Uint64)iLoopGate << 8) +
+			iLoopLane);
+	}
+	for (iLoopLane = 0; iLoopLane < iNrLanes; iLoopLane++)
+		{ *iLeft |= (Uint64)arLane[iLoopLane] << (16 * iLoopLane); }
+	for (iLoopGuard = 0; iLoopGuard < stGame->iNrGuards; iLoopGuard++)
+	{
+		iKey ^= Mix64 (((Uint64)8 << 56) + ((Uint64)iLoopGuard << 32) +
+			stGame->arGuardAttack[iLoopGuard]);
+	}
+	for (iLoopPlatform = 1; iLoopPlatform <= stGame->iNrPlatforms;
+		iLoopPlatform++)
+	{
+		iCell = Cell (stGame->arPlatformRoom[iLoopPlatform],
+			stGame->arPlatformTile[iLoopPlatform]);
+		iKey ^= Mix64 (((Uint64)4 << 56) + ((Uint64)iLoopPlatform << 40) +
+			((Uint64)iCell << 16) + (stGame->arMobDir[iCell] << 8) +
+			stGame->arMobBck[iCell]);
+	}
+
+	arValue[0] = stGame->iPrinceSafe;
+	arValue[1] = stGame->iPrinceFallRows;
+	for (iLoopValue = 0; iLoopValue < 2; iLoopValue++)
+	{
+		iKey ^= Mix64 (((Uint64)(9 + iLoopValue) << 56) +
+			(Uint32)arValue[iLoopValue]);
+	}
+	*iLeft |= (Uint64)(stGame->iCurLives & 0xff) << SOLVE_LIVES;
+
+	return (iKey);
+}
+/*****************************************************************************/
+Uint64 PhaseKey (void)
+/*****************************************************************************/
+{
+	/*** The clock, for StateKey(). Chompers (2 s) and guards (1 s, 0.5 s, ***/
+	/*** 0.4 s) all repeat every SOLVE_PHASES ticks of 80 ms, so ***/
+	/*** iPlayTicks counts only modulo that. iMobMove only moves platforms. ***/
+
+	Uint64 iKey;
+
+	iKey = Mix64 (((Uint64)11 << 56) + (stGame->iPlayTicks % SOLVE_PHASES));
+	if (stGame->iNrPlatforms != 0)
+		{ iKey ^= Mix64 (((Uint64)12 << 56) + stGame->iMobMove); }
+
+	return (iKey);
+}
+/*****************************************************************************/
+Uint64 PhaseTag (void)
+/*****************************************************************************/
+{
+	/*** The phase, for the values of arSolveLeft; see LeftCovers(). ***/
+
+	return ((Uint64)((stGame->iPlayTicks % SOLVE_PHASES) + 1) << SOLVE_TAG);
+}
+/*****************************************************************************/
+int KnownState (Uint64 iKey, Uint64 iLeft)
+/*****************************************************************************/
+{
+	/*** Like SeenState(), but only looks. ***/
+
+	Uint64 iWas;
+	Uint32 iSlot;
+
+	if (iKey == 0) { iKey = 1; }
+	iSlot = (Uint32)iKey & (SOLVE_TABLE - 1);
+	for (;;)
+	{
+		iWas = CompareSwap (&arSolveSeen[iSlot], 0, 0);
+		if (iWas == 0) { return (0); }
+		if (iWas == iKey) { return (KnownLeft (iSlot, iLeft)); }
+		iSlot = (iSlot + 1) & (SOLVE_TABLE - 1);
+	}
+}
+/*****************************************************************************/
+int SolveCheck (void)
+/*****************************************************************************/
+{
+	/*** The hurt potion needs no wait here; dying ends the line. ***/
+
+	while (stGame->iSequence == SEQ_HURT) { EndSequence(); }
+	switch (stGame->iSequence)
+	{
+		case SEQ_DEATH: return (SOLVE_DEAD);
+		case SEQ_LEVEL:
+		case SEQ_VICTORY: return (SOLVE_GOAL);
+	}
+
+	return (SOLVE_OK);
+}
+/*****************************************************************************/
+int PlayAction (int iMove)
+/*****************************************************************************/
+{
+	/*** Plays one of the SOLVE_MOVES. Returns 0 if it cannot be played. ***/
+
+	stGame->iJump = 0;
+	stGame->iCareful = 0;
+	stGame->iRunJump = 0;
+	if (iMove == SOLVE_SWORD)
+	{
+		if (stGame->iPrinceSword != 1) { return (0); }
+		stGame->iPrinceSword = 2;
+	} else if (arSolveMove[iMove] != 0) {
+		PlaySide (arSolveDir[iMove], arSolveMove[iMove]);
+	} else if (arSolveDir[iMove] != 0) {
+		PlayMove (arSolveDir[iMove]);
+	}
+
+	return (1);
+}
+/*****************************************************************************/
+int SolveMove (int iMove)
+/*****************************************************************************/
+{
+	/*** The move, then a game tick, as RunGame() would play them. ***/
+
+	int iResult;
+
+	if (PlayAction (iMove) == 0) { return (SOLVE_DEAD); }
+	iResult = SolveCheck();
+	if (iResult != SOLVE_OK) { return (iResult); }
+	GameActions();
+	iResult = SolveCheck();
+	if (iResult != SOLVE_OK) { return (iResult); }
+	GameTick();
+	iResult = SolveCheck();
+	if (iResult != SOLVE_OK) { return (iResult); }
+	GameActions();
+
+	return (SolveCheck());
+}
+/*****************************************************************************/
+struct solvenode *AddNode (struct solveworker *stWorker,
+	struct solvenode *stParent, int iMove)
+/*****************************************************************************/
+{
+	struct snapshot stNow;
+	struct solvenode *stNew;
+	int iSize;
+
+	Snapshot (&stNow);
+	iSize = EncodeDelta (stSolveBase.sLive, stNow.sLive, stWorker->sDelta);
+	stNew = malloc (sizeof (struct solvenode) + iSize);
+	if (stNew == NULL)
+	{
+		printf ("[FAILED] Could not allocate a solver node!\n");
+		exit (EXIT_ERROR);
+	}
+	stNew->stParent = stParent;
+	stNew->iMove = iMove;
+	stNew->stAnchor = NULL;
+	stNew->iSlow = 0;
+	stNew->iShift = 0;
+	memcpy (stNew->sDelta, stWorker->sDelta, iSize);
+	stNew->stNextNode = stWorker->stNodes;
+	stWorker->stNodes = stNew;
+
+	return (stNew);
+}
+/*****************************************************************************/
+int SolveQuiet (struct solveworker *stWorker, Uint64 *iSlow)
+/*****************************************************************************/
+{
+	/*** Returns 1 if a wait changes nothing but the clock and the gate ***/
+	/*** timers, without reading the clock. Then so does every later ***/
+	/*** wait, at any phase, until a gate closes. *iSlow gets a 1 in the ***/
+	/*** 16 bits of each gate that lost a tick; the others were held open ***/
+	/*** by the prince on their button. ***/
+
+	Uint64 iKey, iLeft;
+	Uint64 iNewKey, iNewLeft;
+	int iTicks, iNewTicks;
+	int iResult;
+	int iQuiet;
+
+	/*** Used for looping. ***/
+	int iLoopGate;
+
+	Snapshot (&stWorker->stMove);
+	iKey = StateKey (&iLeft);
+	iSolveClock = 0;
+	iResult = SolveMove (0);
+	iNewKey = StateKey (&iNewLeft);
+	iQuiet = ((iResult == SOLVE_OK) && (iSolveClock == 0) &&
+		(iNewKey == iKey) && ((iNewLeft & ~SOLVE_TICKS) == (iLeft & ~SOLVE_TICKS)));
+	*iSlow = 0;
+	for (iLoopGate = 0; iLoopGate < SOLVE_LEFT; iLoopGate++)
+	{
+		iTicks = (iLeft >> (16 * iLoopGate)) & 0xffff;
+		iNewTicks = (iNewLeft >> (16 * iLoopGate)) & 0xffff;
+		if (iNewTicks == iTicks - 1)
+		{
+			*iSlow+=(Uint64)1 << (16 * iLoopGate);
+		} else if (iNewTicks != iTicks) { iQuiet = 0; }
+	}
+	if (iQuiet == 0) { *iSlow = 0; }
+	Restore (&stWorker->stMove);
+
+	return (iQuiet);
+}
+/*****************************************************************************/
+void ShiftClock (int iTicks, Uint64 iSlow)
+/*****************************************************************************/
+{
+	/*** As if the prince had waited iTicks more, where nothing changed. ***/
+	/*** The gates of iSlow (see SolveQuiet()) then had that much less ***/
+	/*** time. ***/
+
+	Uint64 iLeft;
+	Uint16 iGateTicks;
+	int iTicksLeft;
+
+	/*** Used for looping. ***/
+	int iLoopGate;
+	int iLoopLane;
+
+	stGame->iPlayTicks+=iTicks;
+	stGame->iMobMove = (stGame->iMobMove + iTicks) % 4;
+	if (iSlow == 0) { return; }
+	StateKey (&iLeft);
+	for (iLoopGate = 1; iLoopGate <= stGame->iNrGates; iLoopGate++)
+	{
+		if (stGame->arWheelSlot[iLoopGate] == 0) { continue; }
+		iGateTicks = stGame->arGateExpiry[iLoopGate] - stGame->iGameTick;
+		for (iLoopLane = 0; iLoopLane < SOLVE_LEFT; iLoopLane++)
+		{
+			iTicksLeft = (iLeft >> (16 * iLoopLane)) & 0xffff;
+			if (iTicksLeft == iGateTicks) { break; }
+		}
+		if ((iLoopLane == SOLVE_LEFT) ||
+			(((iSlow >> (16 * iLoopLane)) & 1) == 0)) { continue; }
+		UnscheduleGate (iLoopGate);
+		stGame->iHash ^= ZobristGate (iLoopGate, stGame->arGateExpiry[iLoopGate]);
+		stGame->arGateExpiry[iLoopGate]-=iTicks;
+		stGame->iHash ^= ZobristGate (iLoopGate, stGame->arGateExpiry[iLoopGate]);
+		ScheduleGate (iLoopGate);
+	}
+}
+/*****************************************************************************/
+int SolveAdd (struct solveworker *stWorker, struct solvenode *stParent,
+	int iMove, int iResult, int iShift)
+/*****************************************************************************/
+{
+	/*** Adds the state the game is in, reached from stParent with iMove, ***/
+	/*** if it is new. iShift is -1 if the move did not read the clock, ***/
+	/*** else the ticks waited first at the anchor of stParent. Returns 0 ***/
+	/*** when the states cap is hit. ***/
+
+	struct solvenode *stNew;
+	struct solvenode ***arList;
+	int *iNr, *iMax;
+	Uint64 iKey, iLeft, iPhase;
+	Uint64 iSlow;
+	int iAnyPhase;
+
+	if (iResult == SOLVE_DEAD) { return (1); }
+	iKey = StateKey (&iLeft);
+	iPhase = 0;
+	iSlow = 0;
+	if ((iShift == -1) && (stParent->stAnchor != NULL))
+	{
+		iAnyPhase = 1;
+		if (stParent->iSlow != 0) { iPhase = PhaseTag(); }
+	} else {
+		/*** Seen for all phases, or before this one, then also for it. ***/
+		if (KnownState (iKey ^ SOLVE_ANY_PHASE, iLeft | PhaseTag()) == 1)
+			{ return (1); }
+		iAnyPhase = ((iResult == SOLVE_OK) &&
+			(SolveQuiet (stWorker, &iSlow) == 1));
+		if ((iAnyPhase == 1) && (iSlow != 0)) { iPhase = PhaseTag(); }
+	}
+	if (iAnyPhase == 1) { iKey ^= SOLVE_ANY_PHASE; } else { iKey ^= PhaseKey(); }
+	if (SeenState (iKey, iLeft | iPhase) == 1) { return (1); }
+	if (SDL_AtomicAdd (&stSolveStates, 1) >= SOLVE_MAX_STATES)
+	{
+		SDL_AtomicSet (&stSolveStop, 1);
+		return (0);
+	}
+
+	stNew = AddNode (stWorker, stParent, iMove);
+	if (iShift > 0) { stNew->iShift = iShift; }
+	if (iAnyPhase == 1)
+	{
+		if ((iShift == -1) && (stParent->stAnchor != NULL))
+		{
+			stNew->stAnchor = stParent->stAnchor;
+			stNew->iSlow = stParent->iSlow;
+		} else {
+			stNew->stAnchor = stNew;
+			stNew->iSlow = iSlow;
+		}
+	}
+	if (iResult == SOLVE_GOAL)
+	{
+		if (SDL_AtomicCAS (&stSolveFound, 0, 1) == SDL_TRUE)
+			{ stSolveGoal = stNew; }
+		return (1);
+	}
+
+	/*** Moves without a step stay in the same layer. ***/
+	if (arSolveDir[iMove] == 0)
+	{
+		arList = &stWorker->arWait;
+		iNr = &stWorker->iNrWait;
+		iMax = &stWorker->iMaxWait;
+	} else {
+		arList = &stWorker->arNext;
+		iNr = &stWorker->iNrNext;
+		iMax = &stWorker->iMaxNext;
+	}
+	if (*iNr == *iMax)
+	{
+		*iMax = (*iMax * 2) + 64;
+		*arList = realloc (*arList, *iMax * sizeof (struct solvenode *));
+		if (*arList == NULL)
+		{
+			printf ("[FAILED] Could not allocate a solver list!\n");
+			exit (EXIT_ERROR);
+		}
+	}
+	(*arList)[*iNr] = stNew;
+	(*iNr)++;
+
+	return (1);
+}
+/*****************************************************************************/
+void SolveNode (struct solveworker *stWorker, struct solvenode *stNode)
+/*****************************************************************************/
+{
+	/*** Waits take no step, so if waiting changes nothing but the clock, ***/
+	/*** all phases of a state cost the same: such a node stands for all ***/
+	/*** of them, and so do the nodes after it, for as long as no move ***/
+	/*** reads the clock (iSolveClock). A move that does is tried at each ***/
+	/*** phase, as if the prince had waited first at the anchor. If gates ***/
+	/*** run down there (iSlow), waiting costs their time: a phase is then ***/
+	/*** only had with less time, and no gate may close or start on the ***/
+	/*** way. ***/
+	/*** The last wait before one closes is then tried apart. ***/
+
+	Uint64 iLeft, iTick, iNewLeft;
+	int iResult;
+	int iShifts, iLast;
+	int iTicks;
+
+	/*** Used for looping. ***/
+	int iLoopMove;
+	int iLoopShift;
+	int iLoopGate;
+
+	stWorker->stNode = stSolveBase;
+	ApplyDelta (stNode->sDelta, stWorker->stNode.sLive);
+
+	/*** The shifts to try, which a gate must outlast. ***/
+	iShifts = SOLVE_PHASES;
+	iLast = -1;
+	iLeft = 0;
+	iTick = 0;
+	if (stNode->iSlow != 0)
+	{
+		Restore (&stWorker->stNode);
+		StateKey (&iLeft);
+		iTick = stNode->iSlow;
+		for (iLoopGate = 0; iLoopGate < SOLVE_LEFT; iLoopGate++)
+		{
+			if (((iTick >> (16 * iLoopGate)) & 1) == 0) { continue; }
+			iTicks = (iLeft >> (16 * iLoopGate)) & 0xffff;
+			if (iTicks <= iShifts) { iShifts = iTicks; iLast = iTicks - 1; }
+		}
+	}
+
+	for (iLoopMove = 0; iLoopMove < SOLVE_MOVES; iLoopMove++)
+	{
+		/*** Only the waits, or only the steps; see SolveLevel(). ***/
+		if ((arSolveDir[iLoopMove] != 0) != iSolveSteps) { continue; }
+		Restore (&stWorker->stNode);
+		iSolveClock = 0;
+		iResult = SolveMove (iLoopMove);
+		if ((stNode->iSlow != 0) && (iSolveClock == 0) && (iResult != SOLVE_DEAD))
+		{
+			StateKey (&iNewLeft);
+			if (iNewLeft != iLeft - iTick) { iSolveClock = 1; }
+		}
+		if ((iSolveClock == 0) || (stNode->stAnchor == NULL))
+		{
+			if (SolveAdd (stWorker, stNode, iLoopMove, iResult, -1) == 0)
+				{ return; }
+			if ((stNode->stAnchor == NULL) || (iLast < 1)) { continue; }
+			Restore (&stWorker->stNode);
+			ShiftClock (iLast, stNode->iSlow);
+			iResult = SolveMove (iLoopMove);
+			if (SolveAdd (stWorker, stNode, iLoopMove, iResult, iLast) == 0)
+				{ return; }
+			continue;
+		}
+		for (iLoopShift = 0; iLoopShift < iShifts; iLoopShift++)
+		{
+			if (iLoopShift != 0)
+			{
+				Restore (&stWorker->stNode);
+				ShiftClock (iLoopShift, stNode->iSlow);
+				iResult = SolveMove (iLoopMove);
+			}
+			if (SolveAdd (stWorker, stNode, iLoopMove, iResult, iLoopShift) == 0)
+				{ return; }
+		}
+	}
+}
+/*****************************************************************************/
+int SolveThread (void *data)
+/*****************************************************************************/
+{
+	struct solveworker *stWorker;
+	int iAt;
+
+	stWorker = (struct solveworker *)data;
+	UseGame (stWorker->stWorkGame);
+	for (;;)
+	{
+		iAt = iSolveFrom + SDL_AtomicAdd (&stSolveAt, 1);
+		if ((iAt >= iSolveNr) || (SDL_AtomicGet (&stSolveFound) != 0) ||
+			(SDL_AtomicGet (&stSolveStop) != 0)) { break; }
+		if (SDL_GetTicks() - iSolveStart > SOLVE_MAX_SECONDS * 1000)
+		{
+			SDL_AtomicSet (&stSolveStop, 1);
+			break;
+		}
+		SolveNode (stWorker, arSolveList[iAt]);
+	}
+
+	return (0);
+}
+/*****************************************************************************/
+void SolveRun (struct solveworker **arWorker, int iNrWorkers)
+/*****************************************************************************/
+{
+	/*** Runs arSolveList[iSolveFrom] up to arSolveList[iSolveNr]. ***/
+
+	SDL_Thread *arThread[SOLVE_THREADS];
+
+	/*** Used for looping. ***/
+	int iLoopWorker;
+
+	SDL_AtomicSet (&stSolveAt, 0);
+	for (iLoopWorker = 0; iLoopWorker < iNrWorkers; iLoopWorker++)
+	{
+		arThread[iLoopWorker] = SDL_CreateThread (SolveThread, "solve",
+			arWorker[iLoopWorker]);
+		if (arThread[iLoopWorker] == NULL)
+		{
+			printf ("[FAILED] Could not create a thread: %s!\n",
+				SDL_GetError());
+			exit (EXIT_ERROR);
+		}
+	}
+	for (iLoopWorker = 0; iLoopWorker < iNrWorkers; iLoopWorker++)
+		{ SDL_WaitThread (arThread[iLoopWorker], NULL); }
+}
+/*****************************************************************************/
+int SolveLevel (int iLevel)
+/*****************************************************************************/
+{
+	/*** Breadth-first, one layer per step, on all cores. Returns the ***/
+	/*** fewest steps, -1 if there is no way, or SOLVE_GAVE_UP. ***/
+	/*** Waits (and sword swings) take no step, so a layer first runs ***/
+	/*** the waits until no new state comes up, and only then the steps ***/
+	/*** from all of its states. Otherwise a state could be seen first ***/
+	/*** one step too late. Any goal found is then the nearest. ***/
+
+	struct game *stStart;
+	struct solveworker *arWorker[SOLVE_THREADS];
+	int iNrWorkers;
+	int iSteps, iNr;
+	int iWait;
+	Uint32 iStart;
+	struct solvenode *stNode, *stNextNode;
+	int *arSolution;
+	int iNrSolution;
+	Uint64 iKey, iLeft;
+
+	/*** Used for looping. ***/
+	int iLoopWorker;
+
+	iStart = SDL_GetTicks();
+	iSolveStart = iStart;
+	stStart = NewGame();
+	UseGame (stStart);
+	stGame->iCurLevel = iLevel;
+	LoadLevel (iLevel, START_LIVES);
+	Snapshot (&stSolveBase);
+
+	iNrWorkers = SDL_GetCPUCount();
+	if (iNrWorkers < 1) { iNrWorkers = 1; }
+	if (iNrWorkers > SOLVE_THREADS) { iNrWorkers = SOLVE_THREADS; }
+#ifdef NO_THREAD_LOCAL
+	iNrWorkers = 1;
+#endif
+	for (iLoopWorker = 0; iLoopWorker < iNrWorkers; iLoopWorker++)
+	{
+		arWorker[iLoopWorker] = calloc (1, sizeof (struct solveworker));
+		if (arWorker[iLoopWorker] == NULL)
+		{
+			printf ("[FAILED] Could not allocate a solver!\n");
+			exit (EXIT_ERROR);
+		}
+		arWorker[iLoopWorker]->stWorkGame = NewGame();
+		UseGame (arWorker[iLoopWorker]->stWorkGame);
+		Restore (&stSolveBase);
+	}
+	UseGame (stStart);
+
+	memset (arSolveSeen, 0, SOLVE_TABLE * sizeof (Uint64));
+	memset (arSolveFirst, 0, SOLVE_TABLE * sizeof (Uint64));
+	SDL_AtomicSet (&stSolveLefts, 0);
+	SDL_AtomicSet (&stSolveStates, 1);
+	SDL_AtomicSet (&stSolveFound, 0);
+	SDL_AtomicSet (&stSolveStop, 0);
+	stSolveGoal = NULL;
+	iSolveNr = 0;
+	stNode = AddNode (arWorker[0], NULL, 0);
+	iKey = StateKey (&iLeft);
+	if (SolveQuiet (arWorker[0], &stNode->iSlow) == 1)
+	{
+		stNode->stAnchor = stNode;
+		SeenState (iKey ^ SOLVE_ANY_PHASE, iLeft |
+			((stNode->iSlow != 0) ? PhaseTag() : 0));
+	} else {
+		SeenState (iKey ^ PhaseKey(), iLeft);
+	}
+	arSolveList[iSolveNr++] = stNode;
+
+	iSteps = 0;
+	for (;;)
+	{
+		/*** The waits, until they add nothing. ***/
+		iSolveSteps = 0;
+		iSolveFrom = 0;
+		while ((iSolveFrom < iSolveNr) && (SDL_AtomicGet (&stSolveFound) == 0) &&
+			(SDL_AtomicGet (&stSolveStop) == 0))
+		{
+			SolveRun (arWorker, iNrWorkers);
+			iSolveFrom = iSolveNr;
+			for (iLoopWorker = 0; iLoopWorker < iNrWorkers; iLoopWorker++)
+			{
+				for (iWait = 0; iWait < arWorker[iLoopWorker]->iNrWait; iWait++)
+					{ arSolveList[iSolveNr++] = arWorker[iLoopWorker]->arWait[iWait]; }
+				arWorker[iLoopWorker]->iNrWait = 0;
+			}
+		}
+		if ((SDL_AtomicGet (&stSolveFound) != 0) ||
+			(SDL_AtomicGet (&stSolveStop) != 0)) { break; }
+
+		/*** Then the steps, from all of them. ***/
+		iSolveSteps = 1;
+		iSolveFrom = 0;
+		SolveRun (arWorker, iNrWorkers);
+		if ((SDL_AtomicGet (&stSolveFound) != 0) ||
+			(SDL_AtomicGet (&stSolveStop) != 0)) { break; }
+		iSolveNr = 0;
+		for (iLoopWorker = 0; iLoopWorker < iNrWorkers; iLoopWorker++)
+		{
+			for (iNr = 0; iNr < arWorker[iLoopWorker]->iNrNext; iNr++)
+				{ arSolveList[iSolveNr++] = arWorker[iLoopWorker]->arNext[iNr]; }
+			arWorker[iLoopWorker]->iNrNext = 0;
+		}
+		if (iSolveNr == 0) { break; }
+		iSteps++;
+		printf ("[ INFO ] Level %i: %i steps, %i states, %.1f s.\n", iLevel,
+			iSteps, SDL_AtomicGet (&stSolveStates),
+			(SDL_GetTicks() - iStart) / 1000.0);
+		fflush (stdout);
+	}
+
+	if (stSolveGoal != NULL)
+	{
+		/*** The steps the game itself counts, playing it from the start. ***/
+		arSolution = SolutionMoves (stSolveGoal, &iNrSolution);
+		iSteps = SolveReplay (arSolution, iNrSolution);
+		if (iSteps == -1)
+		{
+			printf ("[ WARN ] Level %i: the solution does not replay; par"
+				" unknown.\n", iLevel);
+			iSteps = SOLVE_GAVE_UP;
+		} else {
+			printf ("[ INFO ] Level %i: solved in %i steps (%i states, %.1f s):\n",
+				iLevel, iSteps, SDL_AtomicGet (&stSolveStates),
+				(SDL_GetTicks() - iStart) / 1000.0);
+		}
+		ShowSolution (arSolution, iNrSolution);
+		free (arSolution);
+	} else if (SDL_AtomicGet (&stSolveStop) != 0) {
+		printf ("[ WARN ] Level %i: gave up after %i states and %.1f s (caps:"
+			" %i states, %i s); par unknown.\n", iLevel,
+			SDL_AtomicGet (&stSolveStates), (SDL_GetTicks() - iStart) / 1000.0,
+			SOLVE_MAX_STATES, SOLVE_MAX_SECONDS);
+		iSteps = SOLVE_GAVE_UP;
+	} else {
+		printf ("[ WARN ] Level %i: no solution in all %i states!\n", iLevel,
+			SDL_AtomicGet (&stSolveStates));
+		iSteps = -1;
+	}
+
+	for (iLoopWorker = 0; iLoopWorker < iNrWorkers; iLoopWorker++)
+	{
+		stNode = arWorker[iLoopWorker]->stNodes;
+		while (stNode != NULL)
+		{
+			stNextNode = stNode->stNextNode;
+			free (stNode);
+			stNode = stNextNode;
+		}
+		free (arWorker[iLoopWorker]->arWait);
+		free (arWorker[iLoopWorker]->arNext);
+		FreeGame (arWorker[iLoopWorker]->stWorkGame);
+		free (arWorker[iLoopWorker]);
+	}
+	FreeGame (stStart);
+
+	return (iSteps);
+}
+/*****************************************************************************/
+int *SolutionMoves (struct solvenode *stGoal, int *iNrSolution)
+/*****************************************************************************/
+{
+	/*** The moves from the start to stGoal, with the waits of shifted ***/
+	/*** nodes put back after their anchors. The caller frees it. ***/
+
+	struct solvenode *stNode, *stWaitAt;
+	int *arSolution;
+	int iNr, iAt, iWaits;
+
+	iNr = 0;
+	for (stNode = stGoal; stNode->stParent != NULL; stNode = stNode->stParent)
+		{ iNr+=1 + stNode->iShift; }
+	arSolution = malloc ((iNr + 1) * sizeof (int));
+	if (arSolution == NULL)
+	{
+		printf ("[FAILED] Could not allocate the solution!\n");
+		exit (EXIT_ERROR);
+	}
+
+	/*** From the back. The anchor is on the path, before the node. ***/
+	iAt = iNr;
+	stWaitAt = NULL;
+	iWaits = 0;
+	for (stNode = stGoal; stNode->stParent != NULL; stNode = stNode->stParent)
+	{
+		if (stNode == stWaitAt)
+			{ while (iWaits > 0) { arSolution[--iAt] = 0; iWaits--; } }
+		arSolution[--iAt] = stNode->iMove;
+		if (stNode->iShift != 0)
+		{
+			stWaitAt = stNode->stParent->stAnchor;
+			iWaits = stNode->iShift;
+		}
+	}
+	while (iWaits > 0) { arSolution[--iAt] = 0; iWaits--; } /*** At the start. ***/
+	*iNrSolution = iNr;
+
+	return (arSolution);
+}
+/*****************************************************************************/
+int SolveReplay (int *arSolution, int iNrSolution)
+/*****************************************************************************/
+{
+	/*** Plays the moves from the start of the level. Returns the steps, ***/
+	/*** or -1 if only the last move does not end the level. ***/
+
+	int iResult;
+
+	/*** Used for looping. ***/
+	int iLoopMove;
+
+	Restore (&stSolveBase);
+	for (iLoopMove = 0; iLoopMove < iNrSolution; iLoopMove++)
+	{
+		iResult = SolveMove (arSolution[iLoopMove]);
+		if (iResult == SOLVE_DEAD) { return (-1); }
+		if (iResult == SOLVE_GOAL)
+		{
+			if (iLoopMove != iNrSolution - 1) { return (-1); }
+			return (stGame->iSteps);
+		}
+	}
+
+	return (-1);
+}
+/*****************************************************************************/
+void ShowSolution (int *arSolution, int iNrSolution)
+/*****************************************************************************/
+{
+	/*** Prints the moves, with repeats as move*count. ***/
+
+	char sMove[MAX_OPTION + 2];
+	int iAt, iTimes, iColumn;
+
+	iColumn = 0;
+	iAt = 0;
+	while (iAt < iNrSolution)
+	{
+		iTimes = 1;
+		while ((iAt + iTimes < iNrSolution) &&
+			(arSolution[iAt + iTimes] == arSolution[iAt]))
+			{ iTimes++; }
+		if (iTimes == 1)
+		{
+			snprintf (sMove, MAX_OPTION, "%s", arSolveName[arSolution[iAt]]);
+		} else {
+			snprintf (sMove, MAX_OPTION, "%s*%i", arSolveName[arSolution[iAt]],
+				iTimes);
+		}
+		if ((iColumn != 0) && (iColumn + 1 + (int)strlen (sMove) > 76))
+		{
+			printf ("\n");
+			iColumn = 0;
+		}
+		if (iColumn == 0) { printf (" "); iColumn = 1; }
+		printf (" %s", sMove);
+		iColumn+=1 + strlen (sMove);
+		iAt+=iTimes;
+	}
+	printf ("\n");
+}
+/*****************************************************************************/
+void SolveLevels (int iLevel)
+/*****************************************************************************/
+{
+	/*** All levels if iLevel is 0. ***/
+
+	int arPar[14 + 2];
+	int iFirst, iLast;
+
+	/*** Used for looping. ***/
+	int iLoopLevel;
+
+	iHeadless = 1;
+	iNoAudio = 1;
+	iNoWait = 0;
+	iSolveMax = SOLVE_MAX_STATES;
+	arSolveList = malloc (iSolveMax * sizeof (struct solvenode *));
+	arSolveSeen = malloc (SOLVE_TABLE * sizeof (Uint64));
+	arSolveFirst = malloc (SOLVE_TABLE * sizeof (Uint64));
+	arSolveLeft = malloc (SOLVE_TABLE * sizeof (Uint64));
+	arSolveNext = malloc (SOLVE_TABLE * sizeof (Uint32));
+	if ((arSolveList == NULL) || (arSolveSeen == NULL) ||
+		(arSolveFirst == NULL) || (arSolveLeft == NULL) ||
+		(arSolveNext == NULL))
+	{
+		printf ("[FAILED] Could not allocate the solver tables!\n");
+		exit (EXIT_ERROR);
+	}
+
+	if (iLevel == 0)
+	{
+		iFirst = 1;
+		iLast = 14;
+	} else {
+		iFirst = iLevel;
+		iLast = iLevel;
+	}
+	for (iLoopLevel = iFirst; iLoopLevel <= iLast; iLoopLevel++)
+		{ arPar[iLoopLevel] = SolveLevel (iLoopLevel); }
+
+	printf ("[ INFO ] Par:");
+	for (iLoopLevel = iFirst; iLoopLevel <= iLast; iLoopLevel++)
+	{
+		switch (arPar[iLoopLevel])
+		{
+			case -1: printf (" -"); break;
+			case SOLVE_GAVE_UP: printf (" ?"); break;
+			default: printf (" %i", arPar[iLoopLevel]); break;
+		}
+	}
+	printf ("\n");
+	printf ("[ INFO ] (- = no way to the exit; ? = gave up)\n");
+
+	free (arSolveList);
+	free (arSolveSeen);
+	free (arSolveFirst);
+	free (arSolveLeft);
+	free (arSolveNext);
+}
+/*****************************************************************************/
+void AgentTick (void)
+/*****************************************************************************/
+{
+	/*** The game tick of RunGame(), without keys, rewind or drawing. ***/
+
+	if (stGame->iFlash > 0) { stGame->iFlash--; }
+	if (stGame->iSequence != SEQ_NONE)
+	{
+		RunSequence();
+	} else {
+		GameTick();
+	}
+	if (stGame->iSequence == SEQ_NONE) { GameActions(); }
+}
+/*****************************************************************************/
+void AgentStep (int iMove, int iTicks, struct agentstep *stStep)
+/*****************************************************************************/
+{
+	/*** Plays iMove (ignored while a sequence runs), then iTicks game ***/
+	/*** ticks. Only the last of these may draw or play sounds. Events ***/
+	/*** are told apart by the sequences they start, so these are not ***/
+	/*** skipped as with --nowait. ***/
+
+	int iHeadlessWas, iNoAudioWas, iNoWaitWas;
+	int iLives, iCoins, iSeq;
+
+	/*** Used for looping. ***/
+	int iLoopTick;
+
+	iHeadlessWas = iHeadless;
+	iNoAudioWas = iNoAudio;
+	iNoWaitWas = iNoWait;
+	iNoWait = 0;
+	memset (stStep, 0, sizeof (struct agentstep));
+	for (iLoopTick = 0; iLoopTick <= iTicks; iLoopTick++)
+	{
+		if (iLoopTick < iTicks)
+		{
+			iHeadless = 1;
+			iNoAudio = 1;
+		} else {
+			iHeadless = iHeadlessWas;
+			iNoAudio = iNoAudioWas;
+		}
+		iLives = stGame->iCurLives;
+		iCoins = stGame->iPrinceCoins;
+		iSeq = stGame->iSequence;
+
+		if (iLoopTick == 0)
+		{
+			if ((iSeq == SEQ_NONE) && (PlayAction (iMove) == 1) &&
+				(stGame->iSequence == SEQ_NONE)) { GameActions(); }
+		} else {
+			AgentTick();
+		}
+
+		/*** Ending these sequences loads a level; nothing to count. ***/
+		if ((iSeq == SEQ_DEATH) || (iSeq == SEQ_LEVEL) ||
+			(iSeq == SEQ_VICTORY)) { continue; }
+		if (stGame->iCurLives < iLives) { stStep->iHurt+=iLives -
+			stGame->iCurLives; }
+		if (stGame->iPrinceCoins > iCoins) { stStep->iCoins+=
+			stGame->iPrinceCoins - iCoins; }
+		if (stGame->iSequence != iSeq)
+		{
+			switch (stGame->iSequence)
+			{
+				case SEQ_DEATH: stStep->iDeaths++; break;
+				case SEQ_LEVEL:
+				case SEQ_VICTORY: stStep->iExits++; break;
+			}
+		}
+	}
+	iNoWait = iNoWaitWas;
+	AgentState (stStep);
+}
+/*****************************************************************************/
+void AgentState (struct agentstep *stStep)
+/*****************************************************************************/
+{
+	stStep->iLevel = stGame->iCurLevel;
+	stStep->iRoom = stGame->iCurRoom;
+	stStep->iTile = stGame->iPrinceTile;
+	stStep->iDir = stGame->iPrinceDir;
+	stStep->iLives = stGame->iCurLives;
+	stStep->iSequence = stGame->iSequence;
+	stStep->iHash = HashGame();
+}
+/*****************************************************************************/
+void AgentLevel (int iLevel, struct agentstep *stStep)
+/*****************************************************************************/
+{
+	stGame->iCurLevel = iLevel;
+	stGame->iSteps = 0;
+	stGame->iSequence = SEQ_NONE;
+	stGame->iPlayTicks = 0;
+	stGame->iSequenceTotal = 0;
+	LoadLevel (iLevel, START_LIVES);
+	AgentStep (0, 0, stStep);
+}
+/*****************************************************************************/
+void AgentPrint (struct agentstep *stStep)
+/*****************************************************************************/
+{
+	printf ("%i %i %i %i %i %i %i %i %i %i %016llx\n", stStep->iCoins,
+		stStep->iHurt, stStep->iDeaths, stStep->iExits, stStep->iLevel,
+		stStep->iRoom, stStep->iTile, stStep->iDir, stStep->iLives,
+		stStep->iSequence, (unsigned long long)stStep->iHash);
+	fflush (stdout);
+}
+/*****************************************************************************/
+void AgentRun (int iLevel)
+/*****************************************************************************/
+{
+	/*** For --agent. Each line on stdin is a move of arSolveName and, ***/
+	/*** optionally, the game ticks to play after it (default 1); or ***/
+	/*** "level NR" or "quit". Each is answered with one line: coins, ***/
+	/*** lives lost, deaths, level exits, then level, room, tile, ***/
+	/*** direction, lives, sequence and state hash. An unknown move ***/
+	/*** plays nothing; its warning goes to stderr. ***/
+
+	char sLine[MAX_LINE + 2];
+	char sWord[MAX_LINE + 2];
+	struct agentstep stStep;
+	int iMove, iTicks, iArg;
+
+	/*** Used for looping. ***/
+	int iLoopMove;
+
+	iHeadless = 1;
+	iNoAudio = 1;
+	iOverlay = OVL_NONE;
+	AgentLevel (iLevel, &stStep);
+	AgentPrint (&stStep);
+	while (fgets (sLine, MAX_LINE, stdin) != NULL)
+	{
+		if (sscanf (sLine, "%s", sWord) != 1) { continue; }
+		if (strcmp (sWord, "quit") == 0) { break; }
+		if (sscanf (sLine, "%s %d", sWord, &iArg) != 2) { iArg = -1; }
+		if (strcmp (sWord, "level") == 0)
+		{
+			if ((iArg < 1) || (iArg > 14)) { iArg = iLevel; }
+			AgentLevel (iArg, &stStep);
+			AgentPrint (&stStep);
+			continue;
+		}
+		iMove = -1;
+		for (iLoopMove = 0; iLoopMove < SOLVE_MOVES; iLoopMove++)
+		{
+			if (strcmp (sWord, arSolveName[iLoopMove]) == 0)
+				{ iMove = iLoopMove; }
+		}
+		if (iMove == -1)
+		{
+			/*** Not on stdout; that has one line per command. ***/
+			fprintf (stderr, "[ WARN ] Unknown move \"%s\"!\n", sWord);
+			memset (&stStep, 0, sizeof (struct agentstep));
+			AgentState (&stStep);
+			AgentPrint (&stStep);
+			continue;
+		}
+		iTicks = (iArg == -1) ? 1 : iArg;
+		AgentStep (iMove, iTicks, &stStep);
+		AgentPrint (&stStep);
+	}
+}
+/*****************************************************************************/
+int ReachFlags (int iCell)
+/*****************************************************************************/
+{
+	/*** What the prince may do in a cell, with the best possible timing. ***/
+
+	int iFlags;
+	int iReach;
+
+	iFlags = TileFlags (stGame->arTile[iCell]);
+	iReach = arReachExtra[iCell];
+	if ((iFlags & TILE_FLOOR) != 0) { iReach |= REACH_STAND | REACH_PASS; }
+	if ((iFlags & TILE_EMPTY) != 0) { iReach |= REACH_PASS | REACH_HOLE; }
+	if ((iFlags & (TILE_LOOSE | TILE_PLATFORM)) != 0) { iReach |= REACH_HOLE; }
+
+	return (iReach);
+}
+/*****************************************************************************/
+void ReachCell (int iCell)
+/*****************************************************************************/
+{
+	if ((iCell == 0) || (arReached[iCell] == 1)) { return; }
+	if (TriggerEnds (TRIG_ENTER, iCell) == 1) { iReachExit = 1; }
+	arReached[iCell] = 1;
+	arReachQueue[iReachNr] = iCell;
+	iReachNr++;
+}
+/*****************************************************************************/
+void ReachLine (int iCell, int iDir, int iTurns)
+/*****************************************************************************/
+{
+	/*** Walks (1), jumps (3) or run-jumps (6), like TryGoSide(). ***/
+
+	int iNext;
+	int iNeed;
+
+	/*** Used for looping. ***/
+	int iLoopTurn;
+
+	for (iLoopTurn = 1; iLoopTurn <= iTurns; iLoopTurn++)
+	{
+		iNext = stGame->arReal[iCell + arDirOffset[iDir]];
+		if ((iTurns == 6) && (iLoopTurn <= 2))
+		{
+			iNeed = REACH_STAND;
+		} else {
+			iNeed = REACH_PASS;
+		}
+		if ((ReachFlags (iNext) & iNeed) == 0)
+		{
+			if ((iTurns != 6) || (iLoopTurn <= 2) || (iDir != TO_LEFT) ||
+				(stGame->arTile[iNext] != '%')) { break; }
+		}
+
+		iCell = iNext;
+		if ((iTurns == 6) && (iLoopTurn <= 2)) { ReachCell (iCell); }
+	}
+	ReachCell (iCell);
+}
+/*****************************************************************************/
+void ReachFall (int iCell)
+/*****************************************************************************/
+{
+	/*** Like FallPrince(), grabbing any ledge on the way down. ***/
+
+	int iBelow;
+	int iRows;
+	int iReach;
+
+	iRows = 0;
+	while ((ReachFlags (iCell) & REACH_HOLE) != 0)
+	{
+		iBelow = stGame->arReal[iCell + ROOM_W];
+		if (iBelow == 0)
+		{
+			if (TriggerEnds (TRIG_FALL, iCell) == 1) { iReachExit = 1; }
+			return;
+		}
+		iCell = iBelow;
+		iRows++;
+		iReach = ReachFlags (iCell);
+		if (((iReach & REACH_STAND) == 0) &&
+			(((ReachFlags (stGame->arReal[iCell - ROOM_W - 1]) |
+			ReachFlags (stGame->arReal[iCell - ROOM_W + 1])) & REACH_STAND) != 0))
+			{ ReachCell (iCell); } /*** Hangs. ***/
+		if (((iReach & REACH_STAND) != 0) && ((iRows < 3) || (iReachFloat == 1)))
+			{ ReachCell (iCell); }
+	}
+}
+/*****************************************************************************/
+void ReachMoves (int iCell)
+/*****************************************************************************/
+{
+	int iUp, iUpLeft, iUpRight, iLeft, iRight, iDown;
+	int iReach;
+	char cChar;
+	char cGoTo;
+	int iTo;
+
+	iUp = stGame->arReal[iCell - ROOM_W];
+	iUpLeft = stGame->arReal[iCell - ROOM_W - 1];
+	iUpRight = stGame->arReal[iCell - ROOM_W + 1];
+	iLeft = stGame->arReal[iCell - 1];
+	iRight = stGame->arReal[iCell + 1];
+	iDown = stGame->arReal[iCell + ROOM_W];
+	iReach = ReachFlags (iCell);
+
+	if ((iReach & REACH_STAND) != 0)
+	{
+		ReachLine (iCell, TO_LEFT, 1);
+		ReachLine (iCell, TO_LEFT, 3);
+		ReachLine (iCell, TO_LEFT, 6);
+		ReachLine (iCell, TO_RIGHT, 1);
+		ReachLine (iCell, TO_RIGHT, 3);
+		ReachLine (iCell, TO_RIGHT, 6);
+
+		/*** Teleports left/right. ***/
+		cChar = stGame->arTile[iCell];
+		if ((TileFlags (cChar) & TILE_TELEPORT) != 0)
+		{
+			if (cChar == ',')
+			{
+				cGoTo = stGame->arTile[iLeft];
+				iCell = iLeft;
+			} else {
+				cGoTo = cChar;
+			}
+			iTo = stGame->arTeleport[(unsigned char)cGoTo][0];
+			if (iTo == iCell) { iTo = stGame->arTeleport[(unsigned char)cGoTo][1]; }
+			ReachCell (iTo);
+		}
+	}
+
+	/*** Up and down, like TryGoUp() and TryGoDown(). ***/
+	if ((ReachFlags (iUp) & REACH_HOLE) != 0)
+	{
+		if ((ReachFlags (iUpLeft) & REACH_STAND) != 0) { ReachCell (iUpLeft); }
+		if ((ReachFlags (iUpRight) & REACH_STAND) != 0) { ReachCell (iUpRight); }
+	}
+	if (((ReachFlags (iUp) & REACH_STAND) != 0) &&
+		((((ReachFlags (iUpLeft) & REACH_HOLE) != 0) &&
+		((ReachFlags (iLeft) & REACH_PASS) != 0)) ||
+		(((ReachFlags (iUpRight) & REACH_HOLE) != 0) &&
+		((ReachFlags (iRight) & REACH_PASS) != 0)))) { ReachCell (iUp); }
+	if (((ReachFlags (iDown) & REACH_PASS) != 0) &&
+		(((ReachFlags (iLeft) | ReachFlags (iRight)) & REACH_HOLE) != 0))
+		{ ReachCell (iDown); }
+
+	if ((iReach & REACH_HOLE) != 0) { ReachFall (iCell); }
+}
+/*****************************************************************************/
+void ReachAll (void)
+/*****************************************************************************/
+{
+	/*** Flood fills from the start, then drops the loose floors it can. ***/
+
+	int iCell, iBelow;
+	int iDrop;
+
+	/*** Used for looping. ***/
+	int iLoopCell;
+	int iLoopDir;
+
+	memset (arReached, 0, sizeof (arReached));
+	memset (arReachHit, 0, sizeof (arReachHit));
+	iReachNr = 0;
+	iReachExit = 0;
+	ReachCell (Cell (stGame->iCurRoom, stGame->iPrinceTile));
+	for (iLoopCell = 0; iLoopCell < iReachNr; iLoopCell++)
+		{ ReachMoves (arReachQueue[iLoopCell]); }
+
+	for (iLoopCell = ROOM_CELLS; iLoopCell < (ROOMS + 1) * ROOM_CELLS;
+		iLoopCell++)
+	{
+		if ((stGame->arReal[iLoopCell] != iLoopCell) ||
+			(stGame->arTile[iLoopCell] != '~')) { continue; }
+
+		/*** Stepped on, or reached from the side or from below. ***/
+		iDrop = arReached[iLoopCell];
+		for (iLoopDir = 1; iLoopDir <= DIRS; iLoopDir++)
+		{
+			if (arReached[stGame->arReal[iLoopCell -
+				arDirOffset[iLoopDir]]] == 1) { iDrop = 1; }
+		}
+		if (iDrop == 0) { continue; }
+
+		iCell = iLoopCell;
+		do {
+			iBelow = stGame->arReal[iCell + ROOM_W];
+			iCell = iBelow;
+		} while ((iBelow != 0) && (IsEmpty (stGame->arTile[iBelow]) == 1));
+		arReachHit[iBelow] = 1;
+	}
+}
+/*****************************************************************************/
+int ReachTriggers (void)
+/*****************************************************************************/
+{
+	/*** Marks the buttons that press and crush instructions press, if ***/
+	/*** their trigger may run: its room, or tile, is reached. Returns 1 ***/
+	/*** if that is a new button. ***/
+
+	struct trigger *stTrigger;
+	int iRoom, iCell;
+	int iRuns, iCode;
+	int iChanged;
+
+	/*** Used for looping. ***/
+	int iLoopTrigger;
+	int iLoopCell;
+
+	iChanged = 0;
+	for (iLoopTrigger = 1; iLoopTrigger <= stGame->iNrTriggers; iLoopTrigger++)
+	{
+		stTrigger = &stGame->arTrigger[iLoopTrigger];
+		iRuns = (stTrigger->iEvent == TRIG_START);
+		for (iLoopCell = 0; (iLoopCell < iReachNr) && (iRuns == 0); iLoopCell++)
+		{
+			iCell = arReachQueue[iLoopCell];
+			iRoom = iCell / ROOM_CELLS;
+			if (((stTrigger->iRoom == 0) || (stTrigger->iRoom == iRoom)) &&
+				((stTrigger->iTile == 0) ||
+				(stTrigger->iTile == arCellTile[iCell % ROOM_CELLS])))
+				{ iRuns = 1; }
+		}
+		if (iRuns == 0) { continue; }
+		iCode = stTrigger->iCode;
+		while (stGame->arTrigCode[iCode] != CODE_END)
+		{
+			if ((stGame->arTrigCode[iCode] == CODE_PRESS) ||
+				(stGame->arTrigCode[iCode] == CODE_CRUSH))
+			{
+				iCell = Cell (stGame->arTrigCode[iCode + 1],
+					stGame->arTrigCode[iCode + 2]);
+				if (arReachPress[iCell] == 0)
+				{
+					arReachPress[iCell] = 1;
+					iChanged = 1;
+				}
+			}
+			iCode+=arCodeDefs[stGame->arTrigCode[iCode]].iArgs + 1;
+		}
+	}
+
+	return (iChanged);
+}
+/*****************************************************************************/
+int ReachPressed (int iCell)
+/*****************************************************************************/
+{
+	/*** Returns 1 if the button in iCell can be pressed. ***/
+
+	return (arReached[iCell] | arReachHit[iCell] | arReachPress[iCell]);
+}
+/*****************************************************************************/
+int ButtonPressed (int iChar)
+/*****************************************************************************/
+{
+	/*** Returns 1 if any button iChar can be pressed. ***/
+
+	/*** Used for looping. ***/
+	int iLoopCell;
+
+	for (iLoopCell = ROOM_CELLS; iLoopCell < (ROOMS + 1) * ROOM_CELLS;
+		iLoopCell++)
+	{
+		if ((stGame->arReal[iLoopCell] == iLoopCell) &&
+			(stGame->arTile[iLoopCell] == iChar) &&
+			(ReachPressed (iLoopCell) == 1)) { return (1); }
+	}
+
+	return (0);
+}
+/*****************************************************************************/
+int AnalyzeLevel (int iLevel)
+/*****************************************************************************/
+{
+	/*** Returns the number of problems: coins that cannot be collected, ***/
+	/*** or no way out. Buttons that are never pressed and exits that ***/
+	/*** cannot be reached are only warnings, in iAnalyzeWarnings; the ***/
+	/*** stock levels have decoys. Assumes the best possible timing, so ***/
+	/*** everything that is reported can really never be reached. ***/
+
+	int iCell, iNext, iTarget;
+	int iDir;
+	char cChar;
+	int iFlags;
+	int iChanged;
+	int iCoins, iMissed;
+	int iExits, iOpen, iOpener;
+	int iProblems, iWarnings;
+
+	/*** Used for looping. ***/
+	int iLoopPlatform;
+	int iLoopCell;
+	int iLoopTarget;
+	int iLoopSide;
+	int iLoopChar;
+
+	ReadLevel (iLevel);
+	memset (arReachExtra, 0, sizeof (arReachExtra));
+	memset (arReachPress, 0, sizeof (arReachPress));
+	iReachFloat = 0;
+
+	/*** Moving platforms can carry the prince anywhere along their path. ***/
+	for (iLoopPlatform = 1; iLoopPlatform <= stGame->iNrPlatforms;
+		iLoopPlatform++)
+	{
+		iCell = Cell (stGame->arPlatformRoom[iLoopPlatform],
+			stGame->arPlatformTile[iLoopPlatform]);
+		iDir = stGame->arMobDir[iCell];
+		for (iLoopSide = 1; iLoopSide <= 2; iLoopSide++)
+		{
+			iNext = stGame->arReal[iCell + arDirOffset[iDir]];
+			while ((stGame->arTile[iNext] == '.') || (stGame->arTile[iNext] == '`'))
+			{
+				arReachExtra[iNext] = REACH_STAND;
+				iNext = stGame->arReal[iNext + arDirOffset[iDir]];
+			}
+			/*** The arMobDir values are TO_LEFT/RIGHT and TO_UP/DOWN pairs. ***/
+			if ((iDir % 2) == 1) { iDir++; } else { iDir--; }
+		}
+	}
+
+	/*** Buttons open gates, which may lead to more buttons. ***/
+	do {
+		iChanged = 0;
+		ReachAll();
+		if (ReachTriggers() == 1) { iChanged = 1; }
+		for (iLoopCell = 0; iLoopCell < iReachNr; iLoopCell++)
+		{
+			iCell = arReachQueue[iLoopCell];
+			if ((arTileDown[(unsigned char)stGame->arTile[iCell]] == ACT_FLOAT) &&
+				(iReachFloat == 0))
+			{
+				iReachFloat = 1;
+				iChanged = 1;
+			}
+			if (arTileDown[(unsigned char)stGame->arTile[iCell]] == ACT_SWORD)
+			{
+				TakeSword (iCell); /*** May add floors. ***/
+				iChanged = 1;
+			}
+		}
+		for (iLoopCell = ROOM_CELLS; iLoopCell < (ROOMS + 1) * ROOM_CELLS;
+			iLoopCell++)
+		{
+			cChar = stGame->arTile[iLoopCell];
+			iFlags = TileFlags (cChar);
+			if ((stGame->arReal[iLoopCell] != iLoopCell) ||
+				((iFlags & (TILE_BUTTON | TILE_RAISE)) !=
+				(TILE_BUTTON | TILE_RAISE)) ||
+				(ReachPressed (iLoopCell) == 0)) { continue; }
+			for (iLoopTarget = stGame->arButtonFirst[(unsigned char)cChar];
+				iLoopTarget < stGame->arButtonFirst[(unsigned char)cChar + 1];
+				iLoopTarget++)
+			{
+				iTarget = stGame->arTargets[iLoopTarget];
+				if ((stGame->arTile[iTarget] == ')') &&
+					(arReachExtra[iTarget] == 0))
+				{
+					arReachExtra[iTarget] = REACH_STAND | REACH_PASS;
+					iChanged = 1;
+				}
+			}
+		}
+	} while (iChanged == 1);
+
+	iProblems = 0;
+	iWarnings = 0;
+
+	/*** Coins. ***/
+	iCoins = 0;
+	iMissed = 0;
+	for (iLoopCell = ROOM_CELLS; iLoopCell < (ROOMS + 1) * ROOM_CELLS;
+		iLoopCell++)
+	{
+		if ((stGame->arReal[iLoopCell] != iLoopCell) ||
+			(arTileStep[(unsigned char)stGame->arTile[iLoopCell]] != ACT_COIN))
+			{ continue; }
+		iCoins++;
+		if (arReached[iLoopCell] == 0)
+		{
+			printf ("[ WARN ] Level %i: the coin in room %i, tile %i cannot be"
+				" collected!\n", iLevel, iLoopCell / ROOM_CELLS,
+				arCellTile[iLoopCell % ROOM_CELLS]);
+			iMissed++;
+		}
+	}
+	iProblems+=iMissed;
+
+	/*** Buttons. ***/
+	for (iLoopCell = ROOM_CELLS; iLoopCell < (ROOMS + 1) * ROOM_CELLS;
+		iLoopCell++)
+	{
+		cChar = stGame->arTile[iLoopCell];
+		if ((stGame->arReal[iLoopCell] != iLoopCell) ||
+			((TileFlags (cChar) & TILE_BUTTON) == 0)) { continue; }
+		if (ReachPressed (iLoopCell) == 0)
+		{
+			printf ("[ WARN ] Level %i: button %c in room %i, tile %i is never"
+				" pressed!\n", iLevel, cChar, iLoopCell / ROOM_CELLS,
+				arCellTile[iLoopCell % ROOM_CELLS]);
+			iWarnings++;
+		}
+	}
+
+	/*** Level doors. Those no button opens are entrances; those only ***/
+	/*** buttons that are never pressed open, stay shut. ***/
+	iExits = 0;
+	for (iLoopCell = ROOM_CELLS; iLoopCell < (ROOMS + 1) * ROOM_CELLS;
+		iLoopCell++)
+	{
+		cChar = stGame->arTile[iLoopCell];
+		if ((stGame->arReal[iLoopCell] != iLoopCell) ||
+			((cChar != '[') && (cChar != '{'))) { continue; }
+		iOpen = (cChar == '{');
+		iOpener = 0;
+		for (iLoopChar = 0; iLoopChar <= 255; iLoopChar++)
+		{
+			if ((TileFlags (iLoopChar) & (TILE_BUTTON | TILE_RAISE)) !=
+				(TILE_BUTTON | TILE_RAISE)) { continue; }
+			for (iLoopTarget = stGame->arButtonFirst[iLoopChar];
+				iLoopTarget < stGame->arButtonFirst[iLoopChar + 1]; iLoopTarget++)
+			{
+				if (stGame->arTargets[iLoopTarget] != iLoopCell) { continue; }
+				iOpener = 1;
+				if (ButtonPressed (iLoopChar) == 1) { iOpen = 1; }
+			}
+		}
+		if ((iOpen == 0) && (iOpener == 0)) { continue; }
+		iNext = stGame->arReal[iLoopCell + 1];
+		if ((iOpen == 1) && ((arReached[iLoopCell] == 1) || ((iNext != 0) &&
+			(arReached[iNext] == 1) && (stGame->arTile[iNext] == ']'))) &&
+			(iMissed == 0))
+		{
+			iExits++;
+		} else {
+			printf ("[ WARN ] Level %i: the exit in room %i, tile %i cannot be"
+				" reached!\n", iLevel, iLoopCell / ROOM_CELLS,
+				arCellTile[iLoopCell % ROOM_CELLS]);
+			iWarnings++;
+		}
+	}
+	if ((iExits == 0) && (iReachExit == 0))
+	{
+		printf ("[ WARN ] Level %i: no way out!\n", iLevel);
+		iProblems++;
+	}
+
+	printf ("[ INFO ] Level %i: %i tiles reached, %i coins, %i problems, %i"
+		" warnings.\n", iLevel, iReachNr, iCoins, iProblems, iWarnings);
+	iAnalyzeWarnings+=iWarnings;
+
+	return (iProblems);
+}
+/*****************************************************************************/
+int AnalyzeLevels (void)
+/*****************************************************************************/
+{
+	/*** Checks all levels of all games. Returns the number of problems; ***/
+	/*** warnings do not count. ***/
+
+	Uint64 iStart;
+	int iProblems;
+
+	/*** Used for looping. ***/
+	int iLoopGame;
+	int iLoopLevel;
+
+	iProblems = 0;
+	iAnalyzeWarnings = 0;
+	iStart = SDL_GetPerformanceCounter();
+	for (iLoopGame = 1; iLoopGame <= iNrGames; iLoopGame++)
+	{
+		iGameSel = iLoopGame;
+		printf ("[ INFO ] Game \"%s\":\n", arGames[iGameSel]);
+		for (iLoopLevel = 1; iLoopLevel <= 14; iLoopLevel++)
+			{ iProblems+=AnalyzeLevel (iLoopLevel); }
+	}
+	printf ("[ INFO ] Analyzed %i game(s) in %.1f ms: %i problems, %i"
+		" warnings.\n", iNrGames, (double)(SDL_GetPerformanceCounter() - iStart)
+		* 1000 / SDL_GetPerformanceFrequency(), iProblems, iAnalyzeWarnings);
+
+	return (iProblems);
+}
+/*****************************************************************************/
+void Benchmark (void)
+/*****************************************************************************/
+{
+	/*** Compares the old edge checks with the ghost cells. ***/
+
+	Uint64 iStart;
+	double dLinks, dGrid;
+	int iSumLinks, iSumGrid;
+	int iCell;
+	int iLookups;
+
+	/*** Used for looping. ***/
+	int iLoopLevel;
+	int iLoopRound;
+	int iLoopRoom;
+	int iLoopTile;
+	int iLoopDir;
+
+	iLookups = BENCH_ROUNDS * ROOMS * TILES * DIRS;
+	for (iLoopLevel = 1; iLoopLevel <= 14; iLoopLevel++)
+	{
+		ReadLevel (iLoopLevel);
+
+		iSumLinks = 0;
+		iStart = SDL_GetPerformanceCounter();
+		for (iLoopRound = 1; iLoopRound <= BENCH_ROUNDS; iLoopRound++)
+		{
+			for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+			{
+				for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+				{
+					for (iLoopDir = 1; iLoopDir <= DIRS; iLoopDir++)
+					{
+						iCell = NeighbourCell (iLoopRoom, iLoopTile, iLoopDir);
+						iSumLinks+=stGame->arTile[iCell];
+					}
+				}
+			}
+		}
+		dLinks = (double)(SDL_GetPerformanceCounter() - iStart) * 1e9 /
+			(double)SDL_GetPerformanceFrequency() / iLookups;
+
+		iSumGrid = 0;
+		iStart = SDL_GetPerformanceCounter();
+		for (iLoopRound = 1; iLoopRound <= BENCH_ROUNDS; iLoopRound++)
+		{
+			for (iLoopRoom = 1; iLoopRoom <= ROOMS; iLoopRoom++)
+			{
+				for (iLoopTile = 1; iLoopTile <= TILES; iLoopTile++)
+				{
+					for (iLoopDir = 1; iLoopDir <= DIRS; iLoopDir++)
+					{
+						iSumGrid+=GetChar (iLoopRoom, iLoopTile, iLoopDir);
+					}
+				}
+			}
+		}
+		dGrid = (double)(SDL_GetPerformanceCounter() - iStart) * 1e9 /
+			(double)SDL_GetPerformanceFrequency() / iLookups;
+
+		printf ("[ INFO ] Level %2i: links %5.2f ns, grid %5.2f ns per lookup"
+			" (%s).\n", iLoopLevel, dLinks, dGrid,
+			iSumLinks == iSumGrid ? "same tiles" : "DIFFERENT tiles");
+	}
+}